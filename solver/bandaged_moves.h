@@ -4,44 +4,75 @@
 // Helpers for simulating wide moves. No validation is needed here since that is
 // delegated to wide moves.
 
+#include <utility>
+
 #include "board.h"
 
+// Finds the rows dragged along by moving row |offset|. Returns the first row,
+// which may be negative, and the number of rows.
 template <std::size_t num_rows, std::size_t num_cols>
-Board<num_rows, num_cols> bandagedRowMove(Board<num_rows, num_cols> board,
-                                          int offset, bool forward,
-                                          const Validation &validation) {
+std::pair<int, size_t>
+bandagedRowExtent(const LineFlags<num_rows, num_cols> &lines, int offset) {
   size_t depth = 1;
   // sweep up
-  while (depth < num_rows && row_contains_bond(board, offset - 1, DOWN)) {
+  while (depth < num_rows && row_contains_bond(lines, offset - 1, DOWN)) {
     depth += 1;
     offset -= 1;
   }
 
   // sweep down
-  while (depth < num_rows && row_contains_bond(board, offset + depth, UP)) {
+  while (depth < num_rows && row_contains_bond(lines, offset + depth, UP)) {
     depth += 1;
   }
 
-  return wideRowMove(board, offset, forward, validation, depth);
+  return {offset, depth};
 }
 
 template <std::size_t num_rows, std::size_t num_cols>
-Board<num_rows, num_cols> bandagedColMove(Board<num_rows, num_cols> board,
+std::pair<int, size_t>
+bandagedRowExtent(const Board<num_rows, num_cols> &board, int offset) {
+  return bandagedRowExtent(LineFlags<num_rows, num_cols>(board), offset);
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> bandagedRowMove(Board<num_rows, num_cols> board,
                                           int offset, bool forward,
                                           const Validation &validation) {
+  auto [first, depth] = bandagedRowExtent(board, offset);
+  return wideRowMove(board, first, forward, validation, depth);
+}
+
+// Like bandagedRowExtent but for columns.
+template <std::size_t num_rows, std::size_t num_cols>
+std::pair<int, size_t>
+bandagedColExtent(const LineFlags<num_rows, num_cols> &lines, int offset) {
   size_t depth = 1;
   // sweep left
-  while (depth < num_cols && col_contains_bond(board, offset - 1, RIGHT)) {
+  while (depth < num_cols && col_contains_bond(lines, offset - 1, RIGHT)) {
     depth += 1;
     offset -= 1;
   }
 
   // sweep right
-  while (depth < num_cols && col_contains_bond(board, offset + depth, LEFT)) {
+  while (depth < num_cols && col_contains_bond(lines, offset + depth, LEFT)) {
     depth += 1;
   }
 
-  return wideColMove(board, offset, forward, validation, depth);
+  return {offset, depth};
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+std::pair<int, size_t>
+bandagedColExtent(const Board<num_rows, num_cols> &board, int offset) {
+  return bandagedColExtent(LineFlags<num_rows, num_cols>(board), offset);
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> bandagedColMove(Board<num_rows, num_cols> board,
+                                          int offset, bool forward,
+                                          const Validation &validation) {
+  auto [first, depth] = bandagedColExtent(board, offset);
+  return wideColMove(board, first, forward, validation, depth);
 }
 
 #endif
@@ -0,0 +1,178 @@
+// Solves many levels in parallel with the meet-in-the-middle search and prints
+// one tab separated line of results per level.
+//
+// Usage:
+//   bazel run :batch_solve -- --levels_dir=$PWD/../app/src/main/assets/levels
+//   bazel run :batch_solve -- --levels_dir=... --packs=<path to pack>,...
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "dispatch.h"
+#include "level.h"
+#include "mitm.h"
+#include "puzzle.h"
+
+ABSL_FLAG(std::string, levels_dir, "",
+          "Directory containing level files named <canonical id>.txt");
+ABSL_FLAG(std::vector<std::string>, packs, {},
+          "Comma separated list of pack files. If empty, every level in "
+          "--levels_dir is solved.");
+ABSL_FLAG(int, threads, std::thread::hardware_concurrency(),
+          "Number of levels to solve at once");
+ABSL_FLAG(double, max_state_space, 0,
+          "If positive, levels whose estimated state space is larger than "
+          "this are skipped");
+
+struct Job {
+  std::string name;
+  Level level;
+  double state_space;
+};
+
+// Finds the names of the levels to solve.
+std::optional<std::vector<std::string>> levelNames() {
+  const std::string levels_dir = absl::GetFlag(FLAGS_levels_dir);
+  if (levels_dir.empty()) {
+    std::cerr << "--levels_dir is required" << std::endl;
+    return std::nullopt;
+  }
+  std::vector<std::string> names;
+  if (absl::GetFlag(FLAGS_packs).empty()) {
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(levels_dir, error), end;
+         !error && it != end; it.increment(error)) {
+      if (it->path().extension() == ".txt") {
+        names.push_back(it->path().stem().string());
+      }
+    }
+    if (error) {
+      std::cerr << "Couldn't list " << levels_dir << ": " << error.message()
+                << std::endl;
+      return std::nullopt;
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  for (const std::string &path : absl::GetFlag(FLAGS_packs)) {
+    std::optional<std::string> contents = readFile(path);
+    std::optional<Pack> pack =
+        contents ? parsePack(*contents) : std::nullopt;
+    if (!pack) {
+      std::cerr << "Couldn't load pack from " << path << std::endl;
+      return std::nullopt;
+    }
+    names.insert(names.end(), pack->level_ids.begin(), pack->level_ids.end());
+  }
+  return names;
+}
+
+// Length of the shortest solution stored in the level file, or -1 if there
+// isn't one.
+int knownLength(const Level &level) {
+  int ret = -1;
+  for (const auto &solution : level.solutions) {
+    if (ret == -1 || (int)solution.size() < ret) {
+      ret = solution.size();
+    }
+  }
+  return ret;
+}
+
+std::string solve(const Job &job) {
+  const Puzzle &puzzle = job.level.puzzle;
+  auto start = std::chrono::steady_clock::now();
+  MitmResult result;
+  dispatchBySize(puzzle, [&](const auto &initial, const auto &win) {
+    result = solveMitm(initial, win, puzzle.rules);
+    return 0;
+  });
+  double wall_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  return absl::StrJoin(
+      {job.name,
+       result.solved ? std::to_string(result.path.size()) : std::string("-"),
+       std::to_string(knownLength(job.level)),
+       std::to_string(result.states_expanded), std::to_string(wall_ms),
+       std::to_string(result.peak_bytes)},
+      "\t");
+}
+
+int main(int argc, char **argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<std::vector<std::string>> names = levelNames();
+  if (!names) {
+    return 1;
+  }
+
+  std::vector<Job> jobs;
+  for (const std::string &name : *names) {
+    std::string path = absl::GetFlag(FLAGS_levels_dir) + "/" + name + ".txt";
+    std::optional<Level> level = loadLevel(path);
+    if (!level) {
+      std::cerr << "Couldn't load level from " << path << std::endl;
+      return 2;
+    }
+    if (checkPuzzle(level->puzzle) ||
+        !isSupportedSize(level->puzzle.num_rows, level->puzzle.num_cols)) {
+      std::cerr << "Skipping invalid level " << name << std::endl;
+      continue;
+    }
+    double state_space = estimateStateSpace(level->puzzle);
+    if (absl::GetFlag(FLAGS_max_state_space) > 0 &&
+        state_space > absl::GetFlag(FLAGS_max_state_space)) {
+      std::cerr << "Skipping large level " << name << std::endl;
+      continue;
+    }
+    jobs.push_back({name, *level, state_space});
+  }
+
+  // Start the biggest levels first so that a slow one doesn't end up running
+  // alone at the end.
+  std::stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) {
+    return a.state_space > b.state_space;
+  });
+
+  std::cout << "level\tlength\tknown\tstates_expanded\twall_ms\tpeak_bytes"
+            << std::endl;
+  std::atomic<size_t> next_job = 0;
+  std::mutex output_mutex;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < std::max(1, absl::GetFlag(FLAGS_threads)); ++i) {
+    workers.emplace_back([&]() {
+      for (size_t job = next_job++; job < jobs.size(); job = next_job++) {
+        std::string line = solve(jobs[job]);
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << line << std::endl;
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::cerr << "Solved " << jobs.size() << " levels, peak RSS "
+            << usage.ru_maxrss << " KiB" << std::endl;
+
+  return 0;
+}
@@ -1,62 +1,71 @@
-#include <unordered_set>
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
 #include "board.h"
+#include "dispatch.h"
 #include "enums.h"
-#include "moves.h"
-
-constexpr size_t num_rows = 4;
-constexpr size_t num_cols = 2;
-constexpr Board<num_rows, num_cols> initial = {{
-  {{0,0}},
-  {{1,1}},
-  {{2,2}},
-  {{3,3}},
-}};
-
-Mode row_mode = Mode::GEAR;
-Mode col_mode = Mode::GEAR;
-Validation validation = Validation::NONE;
-
-template <std::size_t num_rows, std::size_t num_cols> struct Node {
-  Board<num_rows, num_cols> board;
-  std::string path;
-  Node(const Board<num_rows, num_cols> &b, const std::string &p)
-      : board(b), path(p) {}
-};
-
-template<std::size_t num_rows, std::size_t num_cols>
-void exploreNeighbors(const Board<num_rows, num_cols>& board,
-                      std::queue<Node<num_rows, num_cols>>& q,
-                      std::unordered_set<Board<num_rows, num_cols>>& seen,
-                      const std::string& path) {
-    for (size_t row = 0; row < num_rows; ++row) {
-      Board<num_rows, num_cols> forward = rowMove(board, row, true, row_mode, validation);
-      if (seen.find(forward) == seen.end()) {
-        seen.insert(forward);
-        q.push(Node<num_rows, num_cols>(forward, path + ",R" + std::to_string(row)));
-      }
-
-      Board<num_rows, num_cols> backward = rowMove(board, row, false, row_mode, validation);
-      if (seen.find(backward) == seen.end()) {
-        seen.insert(backward);
-        q.push(Node<num_rows, num_cols>(backward, path + ",R" + std::to_string(row) + "'"));
-      }
-    }
+#include "external_bfs.h"
+#include "layered_search.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "packed_board.h"
+#include "puzzle.h"
+#include "puzzle_flags.h"
+#include "ranked_bfs.h"
+#include "snapshot.h"
+#include "symmetry.h"
 
-    for (size_t col = 0; col < num_cols; ++col) {
-      Board<num_rows, num_cols> forward = colMove(board, col, true, col_mode, validation);
-      if (seen.find(forward) == seen.end()) {
-        seen.insert(forward);
-        q.push(Node<num_rows, num_cols>(forward, path + ",C" + std::to_string(col)));
-      }
+ABSL_FLAG(int, threads, 1, "Number of threads to expand each layer with");
+ABSL_FLAG(bool, symmetry, false,
+          "Print one board out of each set of boards that are symmetric "
+          "with respect to the initial board. The path printed with it then "
+          "leads to a board symmetric to it. Not supported with --enumerate, "
+          "which counts boards.");
+ABSL_FLAG(std::string, external_dir, "",
+          "If set, keep the search on disk in this directory instead of in "
+          "memory, for puzzles with too many boards to fit. Prints the number "
+          "of boards at each depth rather than the boards themselves.");
+ABSL_FLAG(int64_t, external_memory_mb, 1024,
+          "Memory to buffer boards in before sorting and writing them to "
+          "--external_dir.");
+ABSL_FLAG(bool, ranked, false,
+          "Keep 3 bits for every arrangement of the puzzle's cells, in tables "
+          "indexed by rank, instead of a set of the boards found. Takes less "
+          "memory when most arrangements are reachable. Prints the number of "
+          "boards at each depth rather than the boards themselves.");
+ABSL_FLAG(int64_t, ranked_memory_mb, 4096,
+          "Largest table --ranked will allocate.");
+ABSL_FLAG(bool, enumerate, false,
+          "Search from --win instead of --initial and print, as JSON, how "
+          "many boards are at each distance from it, the greatest distance, "
+          "and some of the boards that far away. Uses --external_dir if set, "
+          "otherwise --ranked tables if they fit in --ranked_memory_mb, "
+          "otherwise a set of packed boards.");
+ABSL_FLAG(int, antipodes, 10,
+          "Number of boards at the greatest distance --enumerate prints.");
+ABSL_FLAG(std::string, checkpoint, "",
+          "If set, save the search to this file every --checkpoint_seconds "
+          "and, if the file already holds a save of the same search, pick up "
+          "from it. Not supported with --external_dir.");
+ABSL_FLAG(double, checkpoint_seconds, 600,
+          "How often to save the search to --checkpoint.");
 
-      Board<num_rows, num_cols> backward = colMove(board, col, false, col_mode, validation);
-      if (seen.find(backward) == seen.end()) {
-        seen.insert(backward);
-        q.push(Node<num_rows, num_cols>(backward, path + ",C" + std::to_string(col) + "'"));
-      }
-    }
+// The moves to node |index|, e.g. ",R0,C1'".
+template<std::size_t num_rows, typename Key>
+std::string pathTo(const LayeredSearch<Key>& search, uint32_t index) {
+  std::vector<int> moves = search.movesTo(index);
+  std::string ret;
+  for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+    ret += "," + moveToString<num_rows>(*it);
+  }
+  return ret;
 }
 
 template<std::size_t num_rows, std::size_t num_cols>
@@ -85,35 +94,483 @@ bool shouldPrint(const Board<num_rows, num_cols>& b) {
   return true;
 }
 
-int main () {
-  if (!isCompatible(row_mode, col_mode)) {
-    std::cout << "Row mode and col mode are not compatible" << std::endl;
-    return 1;
+// Names a search for its checkpoints, so that a snapshot is never loaded into
+// a different one. Threads don't change what's found, so they're left out.
+template<std::size_t num_rows, std::size_t num_cols>
+std::string describeSearch(const std::string& kind,
+                           const Board<num_rows, num_cols>& root,
+                           const Rules& rules, bool canonicalize,
+                           size_t key_size) {
+  return "bfs " + kind + " " + std::to_string(num_rows) + "x" +
+         std::to_string(num_cols) + " " +
+         modesToString(rules.row_mode, rules.col_mode, rules.validation) +
+         " " + boardToString(root, rules.row_mode, ",") +
+         (canonicalize ? " symmetry" : "") + " key " +
+         std::to_string(key_size);
+}
+
+// Returns an exit code.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+int exploreAllWithCodec(const Board<num_rows, num_cols>& initial,
+                        const Rules& rules, const Codec& codec, int threads,
+                        bool use_symmetry,
+                        const CheckpointOptions& checkpoint) {
+  using Key = typename Codec::KeyType;
+  LayeredSearch<Key> search(codec.encode(initial),
+      std::min<double>(countArrangements(fromBoard(initial)), kMaxReserve),
+      threads);
+  MoveTable<num_rows, num_cols> moves(rules);
+  // The initial board is its own canonical form since the symmetries fix it.
+  SymmetryGroup<num_rows, num_cols> symmetries(moves, initial);
+  const bool canonicalize = use_symmetry && symmetries.size() > 1;
+  MovePruning<num_rows, num_cols> pruning(moves);
+  auto neighbors = [&](const Key& key, int last_move) {
+    if (canonicalize) {
+      return exploreCanonicalNeighbors(codec.decode(key), key, moves, pruning,
+                                       codec, symmetries);
+    }
+    return exploreNeighbors(codec.decode(key), key, last_move, moves, pruning,
+                            codec);
+  };
+
+  auto print = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      Board<num_rows, num_cols> board = codec.decode(search.nodes()[i].key);
+      if (shouldPrint(board))
+        std::cout << boardToString(board, rules.row_mode, "\n") 
+          << std::endl << pathTo<num_rows>(search, i) << std::endl 
+          << diff(board, initial) << std::endl
+          << std::endl;
+    }
+  };
+
+  Checkpointer checkpointer(checkpoint, describeSearch("all", initial, rules,
+                                                       canonicalize,
+                                                       sizeof(Key)));
+  switch (checkpointer.resume([&](SnapshotReader& reader) {
+    return search.load(reader);
+  })) {
+    case Checkpointer::Resume::FAILED:
+      std::cout << "Couldn't resume from " << checkpoint.path << std::endl;
+      return 10;
+    case Checkpointer::Resume::RESUMED:
+      // Print the boards found before the save again so that the output is
+      // the same as if the search had never stopped.
+      print(0, search.expanded());
+      break;
+    case Checkpointer::Resume::FRESH:
+      break;
   }
-  if (!moveFits(row_mode, num_rows)) {
-    std::cout << "Row move affects too many rows" << std::endl;
-    return 2;
+
+  while (!search.done()) {
+    size_t layer_begin = search.expanded();
+    search.expandLayer(neighbors, false);
+    print(layer_begin, search.expanded());
+    if (!checkpointer.maybeSave([&](SnapshotWriter& writer) {
+          search.save(writer);
+        })) {
+      std::cout << "Couldn't write checkpoint " << checkpoint.path
+                << std::endl;
+      return 10;
+    }
   }
-  if (!moveFits(col_mode, num_cols)) {
-    std::cout << "col move affects too many rows" << std::endl;
-    return 3;
+  return 0;
+}
+
+template<std::size_t num_rows, std::size_t num_cols>
+int exploreAll(const Board<num_rows, num_cols>& initial, const Rules& rules,
+               int threads, bool use_symmetry,
+               const CheckpointOptions& checkpoint) {
+  CellAlphabet alphabet(fromBoard(initial));
+  return withCodec<num_rows, num_cols>(alphabet, [&](const auto& codec) {
+    return exploreAllWithCodec(initial, rules, codec, threads, use_symmetry,
+                               checkpoint);
+  });
+}
+
+// Collects what the searches that count boards, rather than printing them,
+// find at each depth. Without --enumerate each layer is printed as soon as
+// it's found; with it everything is printed at the end as JSON.
+template<std::size_t num_rows, std::size_t num_cols>
+class LayerReport {
+ public:
+  LayerReport(const Rules& rules, bool json, size_t max_samples)
+      : rules_(rules), json_(json), max_samples_(max_samples) {}
+
+  bool json() const { return json_; }
+
+  // Records the size of the next layer, starting with the root's.
+  void addLayer(uint64_t size) {
+    if (!json_) {
+      std::cout << layer_sizes_.size() << " " << size << std::endl;
+    }
+    layer_sizes_.push_back(size);
+    // The boards sampled while expanding the layer before are only the
+    // deepest if this one's empty.
+    if (size > 0) {
+      samples_.clear();
+    }
+  }
+
+  // Number of boards sample() would still keep.
+  size_t samplesWanted() const { return max_samples_ - samples_.size(); }
+
+  // Offers a board from the frontier as it's expanded. The first few are
+  // kept.
+  void sample(const Board<num_rows, num_cols>& board) {
+    if (samples_.size() < max_samples_) {
+      samples_.push_back(board);
+    }
   }
 
-  std::queue<Node<num_rows, num_cols>> q;
-  q.push(Node<num_rows, num_cols>(initial, ""));
-  std::unordered_set<Board<num_rows, num_cols>> seen;
-  seen.insert(initial);
+  // Writes the layers and samples so far so that load() can carry on from
+  // here.
+  void save(SnapshotWriter& writer) const {
+    writer.writeVector(layer_sizes_);
+    writer.writeVector(samples_);
+  }
 
-  while (!q.empty()) {
-    Node<num_rows, num_cols> next = q.front();
-    exploreNeighbors<num_rows, num_cols>(next.board, q, seen, next.path);
-    if (shouldPrint(next.board))
-      std::cout << boardToString(next.board, row_mode, "\n") 
-        << std::endl << next.path << std::endl 
-        << diff(next.board, initial) << std::endl
-        << std::endl;
-    q.pop();
+  // Replaces the layers and samples with ones written by save(), printing the
+  // layers again unless the report is JSON.
+  bool load(SnapshotReader& reader) {
+    if (!reader.readVector(layer_sizes_) || !reader.readVector(samples_)) {
+      return false;
+    }
+    // The save may have been asked for more.
+    samples_.resize(std::min(samples_.size(), max_samples_));
+    if (!json_) {
+      for (size_t depth = 0; depth < layer_sizes_.size(); ++depth) {
+        std::cout << depth << " " << layer_sizes_[depth] << std::endl;
+      }
+    }
+    return true;
   }
 
+  // Prints the number of boards at each depth, the greatest depth, and the
+  // boards sampled at it. Call once the last layer added is empty.
+  void printJson(const std::string& search) const {
+    uint64_t total = 0;
+    std::cout << "{\n  \"search\": \"" << search << "\",\n"
+              << "  \"depth_counts\": [";
+    for (size_t depth = 0; depth + 1 < layer_sizes_.size(); ++depth) {
+      std::cout << (depth ? ", " : "") << layer_sizes_[depth];
+      total += layer_sizes_[depth];
+    }
+    std::cout << "],\n  \"states\": " << total << ",\n"
+              << "  \"max_depth\": " << layer_sizes_.size() - 2 << ",\n"
+              << "  \"antipodes\": [";
+    for (size_t i = 0; i < samples_.size(); ++i) {
+      std::cout << (i ? ",\n    \"" : "\n    \"")
+                << boardToString(samples_[i], rules_.row_mode, ",") << "\"";
+    }
+    std::cout << (samples_.empty() ? "]" : "\n  ]") << "\n}" << std::endl;
+  }
+
+ private:
+  Rules rules_;
+  bool json_;
+  size_t max_samples_;
+  std::vector<uint64_t> layer_sizes_;
+  std::vector<Board<num_rows, num_cols>> samples_;
+};
+
+// Like exploreAll but only counts the boards at each depth, so nothing but the
+// visited set is kept for each board.
+// Returns an exit code.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+int countAllWithCodec(const Board<num_rows, num_cols>& root,
+                      const Rules& rules, const Codec& codec, int threads,
+                      bool use_symmetry, const CheckpointOptions& checkpoint,
+                      LayerReport<num_rows, num_cols>& report) {
+  using Key = typename Codec::KeyType;
+  LayeredSearch<Key> search(codec.encode(root),
+      std::min<double>(countArrangements(fromBoard(root)), kMaxReserve),
+      threads);
+  MoveTable<num_rows, num_cols> moves(rules);
+  SymmetryGroup<num_rows, num_cols> symmetries(moves, root);
+  const bool canonicalize = use_symmetry && symmetries.size() > 1;
+  MovePruning<num_rows, num_cols> pruning(moves);
+  auto neighbors = [&](const Key& key, int last_move) {
+    if (canonicalize) {
+      return exploreCanonicalNeighbors(codec.decode(key), key, moves, pruning,
+                                       codec, symmetries);
+    }
+    return exploreNeighbors(codec.decode(key), key, last_move, moves, pruning,
+                            codec);
+  };
+
+  Checkpointer checkpointer(checkpoint, describeSearch("count", root, rules,
+                                                       canonicalize,
+                                                       sizeof(Key)));
+  auto save = [&](SnapshotWriter& writer) {
+    search.save(writer);
+    report.save(writer);
+  };
+  switch (checkpointer.resume([&](SnapshotReader& reader) {
+    return search.load(reader) && report.load(reader);
+  })) {
+    case Checkpointer::Resume::FAILED:
+      std::cout << "Couldn't resume from " << checkpoint.path << std::endl;
+      return 10;
+    case Checkpointer::Resume::RESUMED:
+      break;
+    case Checkpointer::Resume::FRESH:
+      report.addLayer(1);
+      break;
+  }
+
+  while (!search.done()) {
+    const size_t end = search.expanded() +
+        std::min<size_t>(search.frontierSize(), report.samplesWanted());
+    for (size_t i = search.expanded(); i < end; ++i) {
+      report.sample(codec.decode(search.nodes()[i].key));
+    }
+    search.expandLayer(neighbors, false);
+    report.addLayer(search.frontierSize());
+    if (!checkpointer.maybeSave(save)) {
+      std::cout << "Couldn't write checkpoint " << checkpoint.path
+                << std::endl;
+      return 10;
+    }
+  }
   return 0;
 }
+
+// Like exploreAll but with the layers on disk, reporting how many boards are
+// at each depth. Returns an exit code.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+int countExternallyWithCodec(const Board<num_rows, num_cols>& root,
+                             const Rules& rules, const Codec& codec,
+                             const std::string& dir, size_t max_memory,
+                             bool use_symmetry,
+                             LayerReport<num_rows, num_cols>& report) {
+  using Key = typename Codec::KeyType;
+  if constexpr (std::is_same_v<Key, HashedBoard<num_rows, num_cols>>) {
+    std::cout << "Boards don't fit in 128 bits, which --external_dir needs"
+              << std::endl;
+    return 9;
+  } else {
+    MoveTable<num_rows, num_cols> moves(rules);
+    SymmetryGroup<num_rows, num_cols> symmetries(moves, root);
+    const bool canonicalize = use_symmetry && symmetries.size() > 1;
+    MovePruning<num_rows, num_cols> pruning(moves);
+    // The move into a board isn't kept, so only the pruning that doesn't
+    // depend on it applies.
+    auto neighbors = [&](const Key& key) {
+      const Board<num_rows, num_cols> board = codec.decode(key);
+      report.sample(board);
+      if (canonicalize) {
+        return exploreCanonicalNeighbors(board, key, moves, pruning, codec,
+                                         symmetries);
+      }
+      return exploreNeighbors(board, key, -1, moves, pruning, codec);
+    };
+
+    ExternalBfs<Key> search(dir, max_memory, movesCanBeUndone(rules));
+    if (!search.start(codec.encode(root))) {
+      std::cout << "Couldn't write to " << dir << std::endl;
+      return 10;
+    }
+    report.addLayer(1);
+    while (!search.done()) {
+      if (!search.expandLayer(neighbors)) {
+        std::cout << "Couldn't read or write layer "
+                  << search.layerSizes().size() << " in " << dir << std::endl;
+        return 10;
+      }
+      report.addLayer(search.layerSizes().back());
+    }
+    if (!report.json()) {
+      std::cout << "Peak disk usage " << search.peakBytesOnDisk() << " bytes"
+                << std::endl;
+    }
+    return 0;
+  }
+}
+
+template<std::size_t num_rows, std::size_t num_cols>
+int countExternally(const Board<num_rows, num_cols>& root,
+                    const Rules& rules, const std::string& dir,
+                    size_t max_memory, bool use_symmetry,
+                    LayerReport<num_rows, num_cols>& report) {
+  CellAlphabet alphabet(fromBoard(root));
+  return withCodec<num_rows, num_cols>(alphabet, [&](const auto& codec) {
+    return countExternallyWithCodec(root, rules, codec, dir, max_memory,
+                                    use_symmetry, report);
+  });
+}
+
+template<std::size_t num_rows, std::size_t num_cols>
+int exploreExternally(const Board<num_rows, num_cols>& initial,
+                      const Rules& rules, const std::string& dir,
+                      size_t max_memory, bool use_symmetry) {
+  LayerReport<num_rows, num_cols> report(rules, false, 0);
+  return countExternally(initial, rules, dir, max_memory, use_symmetry,
+                         report);
+}
+
+// Whether --ranked tables for a search from |root| fit in |max_memory|. If
+// not, says why when |explain| is set.
+template<std::size_t num_rows, std::size_t num_cols>
+bool rankedFits(const Board<num_rows, num_cols>& root, size_t max_memory,
+                bool explain) {
+  if (RankedBfs<num_rows, num_cols>::tableSize(root) == 0) {
+    if (explain) {
+      std::cout << "Too many arrangements to rank" << std::endl;
+    }
+    return false;
+  }
+  size_t memory = RankedBfs<num_rows, num_cols>::memoryNeeded(root);
+  if (memory > max_memory) {
+    if (explain) {
+      std::cout << "--ranked needs " << memory << " bytes, more than "
+                << "--ranked_memory_mb allows" << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
+// Like exploreAll but with tables indexed by rank, reporting how many boards
+// are at each depth. rankedFits(root) must hold. Returns an exit code.
+template<std::size_t num_rows, std::size_t num_cols>
+int countRanked(const Board<num_rows, num_cols>& root, const Rules& rules,
+                const CheckpointOptions& checkpoint,
+                LayerReport<num_rows, num_cols>& report) {
+  MoveTable<num_rows, num_cols> moves(rules);
+  RankedBfs<num_rows, num_cols> search(root, moves);
+  Checkpointer checkpointer(checkpoint,
+                            describeSearch("ranked", root, rules, false, 0));
+  auto save = [&](SnapshotWriter& writer) {
+    search.save(writer);
+    report.save(writer);
+  };
+  switch (checkpointer.resume([&](SnapshotReader& reader) {
+    return search.load(reader) && report.load(reader);
+  })) {
+    case Checkpointer::Resume::FAILED:
+      std::cout << "Couldn't resume from " << checkpoint.path << std::endl;
+      return 10;
+    case Checkpointer::Resume::RESUMED:
+      break;
+    case Checkpointer::Resume::FRESH:
+      report.addLayer(1);
+      break;
+  }
+
+  while (!search.done()) {
+    search.expandLayer([&](const Board<num_rows, num_cols>& board) {
+      report.sample(board);
+    });
+    report.addLayer(search.layerSizes().back());
+    if (!checkpointer.maybeSave(save)) {
+      std::cout << "Couldn't write checkpoint " << checkpoint.path
+                << std::endl;
+      return 10;
+    }
+  }
+  if (!report.json()) {
+    std::cout << "Table memory " << search.memoryUsage() << " bytes"
+              << std::endl;
+  }
+  return 0;
+}
+
+template<std::size_t num_rows, std::size_t num_cols>
+int exploreRanked(const Board<num_rows, num_cols>& initial, const Rules& rules,
+                  size_t max_memory, const CheckpointOptions& checkpoint) {
+  if (!rankedFits(initial, max_memory, true)) {
+    return 9;
+  }
+  LayerReport<num_rows, num_cols> report(rules, false, 0);
+  return countRanked(initial, rules, checkpoint, report);
+}
+
+// Counts the boards at each distance from the goal and prints them as JSON
+// along with a few of the furthest boards. Picks the most compact search that
+// applies: on disk if asked for, then ranked tables if they fit, then a set
+// of packed boards. Returns an exit code.
+template<std::size_t num_rows, std::size_t num_cols>
+int enumerate(const Board<num_rows, num_cols>& win, const Rules& rules,
+              const std::string& external_dir,
+              const CheckpointOptions& checkpoint) {
+  LayerReport<num_rows, num_cols> report(
+      rules, true, std::max(0, absl::GetFlag(FLAGS_antipodes)));
+  const size_t ranked_memory = absl::GetFlag(FLAGS_ranked_memory_mb) << 20;
+  if (!external_dir.empty()) {
+    if (int error = countExternally(
+            win, rules, external_dir,
+            absl::GetFlag(FLAGS_external_memory_mb) << 20, false,
+            report)) {
+      return error;
+    }
+    report.printJson("external");
+  } else if (rankedFits(win, ranked_memory, absl::GetFlag(FLAGS_ranked))) {
+    if (int error = countRanked(win, rules, checkpoint, report)) {
+      return error;
+    }
+    report.printJson("ranked");
+  } else if (absl::GetFlag(FLAGS_ranked)) {
+    return 9;
+  } else {
+    CellAlphabet alphabet(fromBoard(win));
+    if (int error = withCodec<num_rows, num_cols>(
+            alphabet, [&](const auto& codec) {
+              return countAllWithCodec(win, rules, codec,
+                                       absl::GetFlag(FLAGS_threads), false,
+                                       checkpoint, report);
+            })) {
+      return error;
+    }
+    report.printJson("in_memory");
+  }
+  return 0;
+}
+
+int main (int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<Puzzle> puzzle = puzzleFromFlags();
+  if (!puzzle) {
+    return 7;
+  }
+  if (int error = checkPuzzle(*puzzle)) {
+    return error;
+  }
+
+  const std::string external_dir = absl::GetFlag(FLAGS_external_dir);
+  const CheckpointOptions checkpoint{absl::GetFlag(FLAGS_checkpoint),
+                                     absl::GetFlag(FLAGS_checkpoint_seconds)};
+  if (!checkpoint.path.empty() && !external_dir.empty()) {
+    std::cout << "--checkpoint isn't supported with --external_dir"
+              << std::endl;
+    return 9;
+  }
+  if (absl::GetFlag(FLAGS_symmetry) && absl::GetFlag(FLAGS_enumerate)) {
+    std::cout << "--symmetry isn't supported with --enumerate" << std::endl;
+    return 9;
+  }
+  if (absl::GetFlag(FLAGS_ranked_memory_mb) < 0 ||
+      absl::GetFlag(FLAGS_external_memory_mb) < 0) {
+    std::cout << "--ranked_memory_mb and --external_memory_mb can't be "
+              << "negative" << std::endl;
+    return 9;
+  }
+  return dispatchBySize(*puzzle, [&](const auto& initial, const auto& win) {
+    if (absl::GetFlag(FLAGS_enumerate)) {
+      return enumerate(win, puzzle->rules, external_dir, checkpoint);
+    }
+    if (absl::GetFlag(FLAGS_ranked)) {
+      return exploreRanked(initial, puzzle->rules,
+                           absl::GetFlag(FLAGS_ranked_memory_mb) << 20,
+                           checkpoint);
+    }
+    if (!external_dir.empty()) {
+      return exploreExternally(
+          initial, puzzle->rules, external_dir,
+          absl::GetFlag(FLAGS_external_memory_mb) << 20,
+          absl::GetFlag(FLAGS_symmetry));
+    }
+    return exploreAll(initial, puzzle->rules, absl::GetFlag(FLAGS_threads),
+                      absl::GetFlag(FLAGS_symmetry), checkpoint);
+  });
+}
@@ -5,6 +5,9 @@
 #include <array>
 #include "absl/strings/str_join.h"
 #include "enums.h"
+#ifdef LOOPINGDICE_USE_SIMD_SLIDE
+#include "simd_slide.h"
+#endif
 #include <iostream>
 
 // A board is a 2D array of ints that can be hashed and printed.
@@ -39,6 +42,12 @@ void slideRow(Board<num_rows, num_cols> &board, int offset, bool forward) {
   // offset is negative.
   int num_rows_i = num_rows;
   offset = ((offset % num_rows_i) + num_rows_i) % num_rows_i;
+#ifdef LOOPINGDICE_USE_SIMD_SLIDE
+  if (slideRowSimd(board[offset].data(), num_cols,
+                   (num_rows - offset) * num_cols, forward)) {
+    return;
+  }
+#endif
   if (forward) {
     int tmp = board[offset][num_cols - 1];
     for (size_t col = num_cols - 1; col > 0; --col) {
@@ -60,6 +69,11 @@ void slideCol(Board<num_rows, num_cols> &board, int offset, bool forward) {
   // offset is negative.
   int num_cols_i = num_cols;
   offset = ((offset % num_cols_i) + num_cols_i) % num_cols_i;
+#ifdef LOOPINGDICE_USE_SIMD_SLIDE
+  if (slideColSimd(&board[0][offset], num_rows, num_cols, forward)) {
+    return;
+  }
+#endif
   if (forward) {
     int tmp = board[num_rows - 1][offset];
     for (size_t row = num_rows - 1; row > 0; --row) {
@@ -77,7 +91,7 @@ void slideCol(Board<num_rows, num_cols> &board, int offset, bool forward) {
 
 
 // Helper for converting a cell to a string
-std::string cellToString(int i) {
+inline std::string cellToString(int i) {
   std::vector<std::string> ret;
   if (i & UP) {
     ret.push_back("U");
@@ -129,6 +143,30 @@ std::string boardToString(const Board<num_rows, num_cols>& board, const Mode& mo
   return absl::StrJoin(board, separator, rowFormatter<num_cols>());
 }
 
+// The flags set on any cell of each row and column, so that checking whether a
+// line contains a flag is a lookup instead of a scan. Building one takes a
+// single pass over the board, which pays off as soon as a few moves of the
+// same board are validated.
+template<std::size_t num_rows, std::size_t num_cols>
+struct LineFlags {
+  std::array<int, num_rows> rows{};
+  std::array<int, num_cols> cols{};
+
+  LineFlags() = default;
+  explicit LineFlags(const Board<num_rows, num_cols>& board) {
+    for (size_t row = 0; row < num_rows; ++row) {
+      for (size_t col = 0; col < num_cols; ++col) {
+        rows[row] |= board[row][col];
+        cols[col] |= board[row][col];
+      }
+    }
+  }
+
+  // |offset| may be up to one lap off the board either way.
+  int row(int offset) const { return rows[(offset + num_rows) % num_rows]; }
+  int col(int offset) const { return cols[(offset + num_cols) % num_cols]; }
+};
+
 // Checks for enablers in a row/col
 template<std::size_t num_rows, std::size_t num_cols>
 bool row_contains_enabler(const Board<num_rows, num_cols>& board, int offset) {
@@ -141,6 +179,10 @@ bool row_contains_enabler(const Board<num_rows, num_cols>& board, int offset) {
   return false;
 }
 template<std::size_t num_rows, std::size_t num_cols>
+bool row_contains_enabler(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.row(offset) & ENABLER;
+}
+template<std::size_t num_rows, std::size_t num_cols>
 bool col_contains_enabler(const Board<num_rows, num_cols>& board, int offset) {
   offset = (offset + num_cols) % num_cols;
   for (size_t row = 0; row < num_rows; ++row) {
@@ -150,6 +192,10 @@ bool col_contains_enabler(const Board<num_rows, num_cols>& board, int offset) {
   }
   return false;
 }
+template<std::size_t num_rows, std::size_t num_cols>
+bool col_contains_enabler(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.col(offset) & ENABLER;
+}
 
 // Checks if a row/col ends in a fixed cell, when swiped in |forward| direction.
 template<std::size_t num_rows, std::size_t num_cols>
@@ -176,6 +222,10 @@ bool row_contains_lightning(const Board<num_rows, num_cols>& board, int offset)
   return false;
 }
 template<std::size_t num_rows, std::size_t num_cols>
+bool row_contains_lightning(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.row(offset) & LIGHTNING;
+}
+template<std::size_t num_rows, std::size_t num_cols>
 bool col_contains_lightning(const Board<num_rows, num_cols>& board, int offset) {
   for (size_t row = 0; row < num_rows; ++row) {
     if(board[row][offset] & LIGHTNING) {
@@ -184,6 +234,10 @@ bool col_contains_lightning(const Board<num_rows, num_cols>& board, int offset)
   }
   return false;
 }
+template<std::size_t num_rows, std::size_t num_cols>
+bool col_contains_lightning(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.col(offset) & LIGHTNING;
+}
 
 // checks if a row/col contains a bond in a given direction.
 template<std::size_t num_rows, std::size_t num_cols>
@@ -197,6 +251,10 @@ bool row_contains_bond(const Board<num_rows, num_cols>& board, int offset, int b
   return false;
 }
 template<std::size_t num_rows, std::size_t num_cols>
+bool row_contains_bond(const LineFlags<num_rows, num_cols>& lines, int offset, int bond) {
+  return lines.row(offset) & bond;
+}
+template<std::size_t num_rows, std::size_t num_cols>
 bool col_contains_bond(const Board<num_rows, num_cols>& board, int offset, int bond) {
   offset = (offset + num_cols) % num_cols;
   for (size_t row = 0; row < num_rows; ++row) {
@@ -206,6 +264,10 @@ bool col_contains_bond(const Board<num_rows, num_cols>& board, int offset, int b
   }
   return false;
 }
+template<std::size_t num_rows, std::size_t num_cols>
+bool col_contains_bond(const LineFlags<num_rows, num_cols>& lines, int offset, int bond) {
+  return lines.col(offset) & bond;
+}
 
 
 // checks if a row/col contains a fixed cell.
@@ -220,6 +282,10 @@ bool row_contains_fixed_cell(const Board<num_rows, num_cols>& board, int offset)
   return false;
 }
 template<std::size_t num_rows, std::size_t num_cols>
+bool row_contains_fixed_cell(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.row(offset) & FIXED;
+}
+template<std::size_t num_rows, std::size_t num_cols>
 bool col_contains_fixed_cell(const Board<num_rows, num_cols>& board, int offset) {
   offset = (offset + num_cols) % num_cols;
   for (size_t row = 0; row < num_rows; ++row) {
@@ -229,6 +295,10 @@ bool col_contains_fixed_cell(const Board<num_rows, num_cols>& board, int offset)
   }
   return false;
 }
+template<std::size_t num_rows, std::size_t num_cols>
+bool col_contains_fixed_cell(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.col(offset) & FIXED;
+}
 
 // checks if a row/col contains an arrows cell in the wrong direction
 template<std::size_t num_rows, std::size_t num_cols>
@@ -242,6 +312,10 @@ bool row_contains_arrows_cell(const Board<num_rows, num_cols>& board, int offset
   return false;
 }
 template<std::size_t num_rows, std::size_t num_cols>
+bool row_contains_arrows_cell(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.row(offset) & VERT;
+}
+template<std::size_t num_rows, std::size_t num_cols>
 bool col_contains_arrows_cell(const Board<num_rows, num_cols>& board, int offset) {
   offset = (offset + num_cols) % num_cols;
   for (size_t row = 0; row < num_rows; ++row) {
@@ -251,5 +325,9 @@ bool col_contains_arrows_cell(const Board<num_rows, num_cols>& board, int offset
   }
   return false;
 }
+template<std::size_t num_rows, std::size_t num_cols>
+bool col_contains_arrows_cell(const LineFlags<num_rows, num_cols>& lines, int offset) {
+  return lines.col(offset) & HORIZ;
+}
 
 #endif
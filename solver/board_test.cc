@@ -164,6 +164,38 @@ TEST(Board, ColContainsFixed) {
   EXPECT_TRUE(col_contains_fixed_cell(b, 1));
 }
 
+TEST(Board, LineFlags) {
+  Board<2, 3> b = {{
+      {{0 | ENABLER, 1 | HORIZ, 2 | LEFT}},
+      {{3 | LIGHTNING, 4 | FIXED, 5 | VERT}},
+  }};
+  LineFlags<2, 3> lines(b);
+
+  // Agrees with scanning the board, including for lines off the edge.
+  for (int offset = -2; offset < 4; ++offset) {
+    EXPECT_EQ(row_contains_enabler(lines, offset),
+              row_contains_enabler(b, offset));
+    EXPECT_EQ(row_contains_fixed_cell(lines, offset),
+              row_contains_fixed_cell(b, offset));
+    EXPECT_EQ(row_contains_arrows_cell(lines, offset),
+              row_contains_arrows_cell(b, offset));
+    EXPECT_EQ(row_contains_bond(lines, offset, LEFT),
+              row_contains_bond(b, offset, LEFT));
+  }
+  for (int offset = -3; offset < 6; ++offset) {
+    EXPECT_EQ(col_contains_enabler(lines, offset),
+              col_contains_enabler(b, offset));
+    EXPECT_EQ(col_contains_fixed_cell(lines, offset),
+              col_contains_fixed_cell(b, offset));
+    EXPECT_EQ(col_contains_arrows_cell(lines, offset),
+              col_contains_arrows_cell(b, offset));
+    EXPECT_EQ(col_contains_bond(lines, offset, LEFT),
+              col_contains_bond(b, offset, LEFT));
+  }
+  EXPECT_TRUE(row_contains_lightning(lines, 1));
+  EXPECT_FALSE(col_contains_lightning(lines, 1));
+}
+
 TEST(Board, hash) {
   std::unordered_set<Board<4, 3>> s;
 
@@ -6,11 +6,13 @@
 #include "board.h"
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateCarouselRowMove(const Board<num_rows, num_cols> &board, int offset,
-                         bool forward, const Validation &validation) {
+bool validateCarouselRowMove(const Board<num_rows, num_cols> &board,
+                             const LineFlags<num_rows, num_cols> &lines,
+                             int offset, bool forward,
+                             const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (row_contains_fixed_cell(board, offset) ||
-        (row_contains_fixed_cell(board, offset + 1))) {
+    if (row_contains_fixed_cell(lines, offset) ||
+        (row_contains_fixed_cell(lines, offset + 1))) {
       return false;
     }
   }
@@ -51,8 +53,8 @@ bool validateCarouselRowMove(const Board<num_rows, num_cols> &board, int offset,
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!row_contains_enabler(board, offset) &&
-        !row_contains_enabler(board, offset + 1)) {
+    if (!row_contains_enabler(lines, offset) &&
+        !row_contains_enabler(lines, offset + 1)) {
       return false;
     }
   }
@@ -60,6 +62,13 @@ bool validateCarouselRowMove(const Board<num_rows, num_cols> &board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateCarouselRowMove(const Board<num_rows, num_cols> &board, int offset,
+                             bool forward, const Validation &validation) {
+  return validateCarouselRowMove(board, LineFlags<num_rows, num_cols>(board),
+                                 offset, forward, validation);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> carouselRowMove(Board<num_rows, num_cols> board,
                                           int offset, bool forward,
@@ -96,11 +105,13 @@ Board<num_rows, num_cols> carouselRowMove(Board<num_rows, num_cols> board,
 }
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateCarouselColMove(const Board<num_rows, num_cols> &board, int offset,
-                         bool forward, const Validation &validation) {
+bool validateCarouselColMove(const Board<num_rows, num_cols> &board,
+                             const LineFlags<num_rows, num_cols> &lines,
+                             int offset, bool forward,
+                             const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (col_contains_fixed_cell(board, offset) ||
-        (col_contains_fixed_cell(board, offset + 1))) {
+    if (col_contains_fixed_cell(lines, offset) ||
+        (col_contains_fixed_cell(lines, offset + 1))) {
       return false;
     }
   }
@@ -142,8 +153,8 @@ bool validateCarouselColMove(const Board<num_rows, num_cols> &board, int offset,
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!col_contains_enabler(board, offset) &&
-        !col_contains_enabler(board, offset + 1)) {
+    if (!col_contains_enabler(lines, offset) &&
+        !col_contains_enabler(lines, offset + 1)) {
       return false;
     }
   }
@@ -151,6 +162,13 @@ bool validateCarouselColMove(const Board<num_rows, num_cols> &board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateCarouselColMove(const Board<num_rows, num_cols> &board, int offset,
+                             bool forward, const Validation &validation) {
+  return validateCarouselColMove(board, LineFlags<num_rows, num_cols>(board),
+                                 offset, forward, validation);
+}
+
 
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> carouselColMove(Board<num_rows, num_cols> board,
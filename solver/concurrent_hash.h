@@ -0,0 +1,245 @@
+// An open addressing hash map that several threads can insert into at once
+// without locks.
+//
+// std::unordered_map allocates a node per entry and follows a pointer on every
+// probe. Here slots instead hold a hash and a key inline, probed linearly so a
+// lookup usually touches a single cache line, with the values in a parallel
+// array. Comparing the stored hashes first means keys, which can be whole
+// boards, are only compared on a likely match. Lookups take the key's hash so
+// that callers can hash a batch of keys, prefetch all of their slots and only
+// then probe, letting the cache misses overlap.
+//
+// A thread claims an empty slot by compare-and-swapping its hash in, writes the
+// key and value, then marks the slot ready. Lookups that reach a claimed slot
+// with a matching hash wait for it to be ready before comparing keys. So
+// inserting is a single probe that either finds the key or claims a slot for
+// it, with no lookup beforehand.
+//
+// The table doesn't grow while threads are inserting. Callers reserve room
+// for as many entries as they might insert before starting them, e.g. once
+// per batch of work; reserve() itself must not run alongside anything else.
+#ifndef LOOPINGDICE_CONCURRENT_HASH
+#define LOOPINGDICE_CONCURRENT_HASH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "snapshot.h"
+
+template <typename Key, typename Value, typename Hash>
+class ConcurrentFlatHashMap {
+  static_assert(std::is_integral_v<Value>, "Values are updated atomically");
+
+public:
+  // Sized so that |expected| entries fit without growing.
+  explicit ConcurrentFlatHashMap(size_t expected = 0) { reserve(expected); }
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+  size_t capacity() const { return capacity_; }
+
+  // Bytes held by the table.
+  size_t memoryUsage() const { return capacity_ * kBytesPerSlot; }
+
+  // The capacity reserve(expected) leaves a table of |capacity| slots with.
+  static size_t capacityFor(size_t expected, size_t capacity) {
+    if (capacity != 0 && expected * kMaxLoadDen <= capacity * kMaxLoadNum) {
+      return capacity;
+    }
+    capacity = std::max(kMinCapacity, capacity);
+    while (capacity * kMaxLoadNum < expected * kMaxLoadDen) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // Bytes held by a table reserved for |expected| entries from empty.
+  static size_t memoryUsageFor(size_t expected) {
+    return capacityFor(expected, 0) * kBytesPerSlot;
+  }
+
+  // The most bytes held while growing to fit |expected| entries in all. That
+  // includes the old table while it's copied to the new one, which is at
+  // most half the size.
+  size_t peakMemoryFor(size_t expected) const {
+    const size_t capacity = capacityFor(expected, capacity_);
+    return (capacity == capacity_ ? capacity : capacity + capacity / 2) *
+           kBytesPerSlot;
+  }
+
+  // Makes room for |expected| entries in all. Not thread safe.
+  void reserve(size_t expected) {
+    const size_t capacity = capacityFor(expected, capacity_);
+    if (capacity != capacity_) {
+      rehash(capacity);
+    }
+  }
+
+  // Hashes are never 0, which marks an empty slot, and leave the top bit
+  // free to mark a slot as ready.
+  uint64_t hash(const Key &key) const {
+    uint64_t h = Hash()(key) & ~kReady;
+    return h == 0 ? 1 : h;
+  }
+
+  void prefetch(uint64_t hash) const {
+    __builtin_prefetch(&slots_[hash & mask_]);
+  }
+
+  // Returns the value stored for |key|, whose hash is |hash|, or nullptr.
+  // Safe to call while other threads insert.
+  std::atomic<Value> *findWithHash(const Key &key, uint64_t hash) const {
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      uint64_t state = slots_[i].state.load(std::memory_order_acquire);
+      if (state == 0) {
+        return nullptr;
+      }
+      if ((state & ~kReady) == hash && waitUntilReady(i) == key) {
+        return &values_[i];
+      }
+    }
+  }
+  std::atomic<Value> *find(const Key &key) const {
+    return findWithHash(key, hash(key));
+  }
+  bool contains(const Key &key) const { return find(key) != nullptr; }
+
+  // Inserts |value| for |key| unless |key| is already present. Returns the
+  // stored value and whether this call inserted it. Safe to call while other
+  // threads insert, as long as the table was reserved for all of them.
+  std::pair<std::atomic<Value> *, bool>
+  insertWithHash(const Key &key, uint64_t hash, Value value = Value()) {
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      uint64_t state = slots_[i].state.load(std::memory_order_acquire);
+      if (state == 0) {
+        if (slots_[i].state.compare_exchange_strong(
+                state, hash, std::memory_order_acquire)) {
+          slots_[i].key = key;
+          values_[i].store(value, std::memory_order_relaxed);
+          slots_[i].state.store(hash | kReady, std::memory_order_release);
+          size_.fetch_add(1, std::memory_order_relaxed);
+          return {&values_[i], true};
+        }
+        // Another thread took the slot first; |state| is now its hash.
+      }
+      if ((state & ~kReady) == hash && waitUntilReady(i) == key) {
+        return {&values_[i], false};
+      }
+    }
+  }
+  std::pair<std::atomic<Value> *, bool> insert(const Key &key,
+                                               Value value = Value()) {
+    return insertWithHash(key, hash(key), value);
+  }
+
+  // Writes the table as it is, for load() to read back without rehashing. Not
+  // thread safe.
+  void save(SnapshotWriter &writer) const {
+    writer.write(capacity_);
+    writer.write(size());
+    writer.writeBytes(slots_.get(), capacity_ * sizeof(Slot));
+    writer.writeBytes(values_.get(), capacity_ * sizeof(std::atomic<Value>));
+  }
+
+  // Replaces the table with one written by save(). A damaged header leaves the
+  // map as it was. Otherwise the old table is freed first, so if reading the
+  // new one fails the map is left empty. Not thread safe.
+  bool load(SnapshotReader &reader) {
+    size_t capacity = 0;
+    size_t size = 0;
+    // Check the slots are there before allocating for them, since a damaged
+    // capacity can be anything.
+    if (!reader.read(capacity) || !reader.read(size) ||
+        capacity < kMinCapacity || (capacity & (capacity - 1)) != 0 ||
+        size > capacity || capacity > SIZE_MAX / sizeof(Slot) ||
+        reader.nextSize() != std::optional<uint64_t>(capacity * sizeof(Slot))) {
+      return false;
+    }
+    slots_.reset();
+    values_.reset();
+    capacity_ = 0;
+    size_.store(0, std::memory_order_relaxed);
+    auto slots = std::make_unique<Slot[]>(capacity);
+    auto values = std::make_unique<std::atomic<Value>[]>(capacity);
+    if (!reader.readBytes(slots.get(), capacity * sizeof(Slot)) ||
+        !reader.readBytes(values.get(),
+                          capacity * sizeof(std::atomic<Value>))) {
+      reserve(0);
+      return false;
+    }
+    slots_ = std::move(slots);
+    values_ = std::move(values);
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+    size_.store(size, std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  struct Slot {
+    // 0 if empty, the hash once claimed, and the hash | kReady once the key
+    // has been written.
+    std::atomic<uint64_t> state{0};
+    Key key;
+  };
+
+  static constexpr uint64_t kReady = uint64_t{1} << 63;
+  // Grow once the table is 3/4 full; linear probing slows down quickly past
+  // that.
+  static constexpr size_t kMaxLoadNum = 3;
+  static constexpr size_t kMaxLoadDen = 4;
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kBytesPerSlot =
+      sizeof(Slot) + sizeof(std::atomic<Value>);
+
+  // Tables are saved and loaded as raw bytes.
+  static_assert(std::is_trivially_copyable_v<Key>);
+  static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+                sizeof(std::atomic<Value>) == sizeof(Value));
+
+  // Returns the key in slot |i| once its inserter has written it. Inserters
+  // don't block, so this only ever waits for a few stores.
+  const Key &waitUntilReady(size_t i) const {
+    while (!(slots_[i].state.load(std::memory_order_acquire) & kReady)) {
+    }
+    return slots_[i].key;
+  }
+
+  void rehash(size_t capacity) {
+    std::unique_ptr<Slot[]> old_slots =
+        std::exchange(slots_, std::make_unique<Slot[]>(capacity));
+    std::unique_ptr<std::atomic<Value>[]> old_values = std::exchange(
+        values_, std::make_unique<std::atomic<Value>[]>(capacity));
+    size_t old_capacity = std::exchange(capacity_, capacity);
+    mask_ = capacity - 1;
+
+    for (size_t j = 0; j < old_capacity; ++j) {
+      uint64_t state = old_slots[j].state.load(std::memory_order_relaxed);
+      if (state == 0) {
+        continue;
+      }
+      size_t i = state & mask_;
+      while (slots_[i].state.load(std::memory_order_relaxed) != 0) {
+        i = (i + 1) & mask_;
+      }
+      slots_[i].state.store(state, std::memory_order_relaxed);
+      slots_[i].key = old_slots[j].key;
+      values_[i].store(old_values[j].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    }
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  // Kept apart from the slots so that probing only touches hashes and keys.
+  std::unique_ptr<std::atomic<Value>[]> values_;
+  size_t capacity_ = 0;
+  size_t mask_ = 0;
+  std::atomic<size_t> size_ = 0;
+};
+
+#endif
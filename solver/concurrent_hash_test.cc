@@ -0,0 +1,174 @@
+#include "concurrent_hash.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "packed_board.h"
+
+TEST(ConcurrentHash, InsertAndFind) {
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map;
+  EXPECT_EQ(map.find(1), nullptr);
+
+  auto [value, inserted] = map.insert(1, 10);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(*value, 10);
+
+  // Doesn't overwrite.
+  std::tie(value, inserted) = map.insert(1, 11);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(*value, 10);
+
+  ASSERT_NE(map.find(1), nullptr);
+  EXPECT_EQ(*map.find(1), 10);
+  EXPECT_EQ(map.size(), 1);
+}
+
+TEST(ConcurrentHash, Reserve) {
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    map.reserve(map.size() + 1);
+    map.insert(uint64_t{i} * 7919, i);
+  }
+  EXPECT_EQ(map.size(), 10000);
+  EXPECT_GE(map.capacity() * 3, map.size() * 4);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    ASSERT_NE(map.find(uint64_t{i} * 7919), nullptr);
+    EXPECT_EQ(*map.find(uint64_t{i} * 7919), i);
+  }
+  EXPECT_EQ(map.find(1), nullptr);
+}
+
+// Growing one entry at a time ends up the same size as reserving for all of
+// them at once, and never holds more than peakMemoryFor() says.
+TEST(ConcurrentHash, MemoryUsage) {
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map;
+  const size_t peak = map.peakMemoryFor(10000);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    map.reserve(map.size() + 1);
+    map.insert(uint64_t{i} * 7919, i);
+  }
+  EXPECT_EQ(map.memoryUsage(),
+            (ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash>::memoryUsageFor(
+                10000)));
+  // The old table was half the size of the final one.
+  EXPECT_EQ(peak, map.memoryUsage() * 3 / 2);
+  EXPECT_EQ(map.peakMemoryFor(10000), map.memoryUsage());
+}
+
+namespace {
+
+// Hashes everything the same so that every insert races for the same slots.
+struct CollidingHash {
+  uint64_t operator()(uint64_t) const { return 42; }
+};
+
+} // namespace
+
+TEST(ConcurrentHash, Collisions) {
+  ConcurrentFlatHashMap<uint64_t, uint32_t, CollidingHash> map(100);
+  for (uint64_t i = 0; i < 100; ++i) {
+    EXPECT_TRUE(map.insert(i, i).second);
+  }
+  for (uint64_t i = 0; i < 100; ++i) {
+    ASSERT_NE(map.find(i), nullptr);
+    EXPECT_EQ(*map.find(i), i);
+  }
+}
+
+// Hashes of 0, and ones with only the ready bit set, would look like empty or
+// half written slots if they were stored as is.
+TEST(ConcurrentHash, ReservedHashes) {
+  struct ZeroHash {
+    uint64_t operator()(uint64_t) const { return 0; }
+  };
+  struct ReadyHash {
+    uint64_t operator()(uint64_t) const { return uint64_t{1} << 63; }
+  };
+  ConcurrentFlatHashMap<uint64_t, uint32_t, ZeroHash> zero;
+  ConcurrentFlatHashMap<uint64_t, uint32_t, ReadyHash> ready;
+  EXPECT_TRUE(zero.insert(5, 1).second);
+  EXPECT_TRUE(ready.insert(5, 1).second);
+  EXPECT_TRUE(zero.contains(5));
+  EXPECT_TRUE(ready.contains(5));
+  EXPECT_FALSE(zero.contains(6));
+  EXPECT_FALSE(ready.contains(6));
+}
+
+TEST(ConcurrentHash, InsertsOnceFromManyThreads) {
+  constexpr int kThreads = 8;
+  constexpr uint64_t kKeys = 100000;
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map(kKeys);
+  std::atomic<size_t> inserted = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    // Every thread inserts every key, in different orders.
+    threads.emplace_back([&, t]() {
+      for (uint64_t i = 0; i < kKeys; ++i) {
+        uint64_t key = (i * (2 * t + 1)) % kKeys;
+        if (map.insert(key, t).second) {
+          ++inserted;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(inserted, kKeys);
+  EXPECT_EQ(map.size(), kKeys);
+  for (uint64_t key = 0; key < kKeys; ++key) {
+    ASSERT_NE(map.find(key), nullptr);
+    EXPECT_LT(*map.find(key), kThreads);
+  }
+}
+
+TEST(ConcurrentHash, SaveAndLoad) {
+  const std::string path = testing::TempDir() + "/concurrent_hash";
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map(1000);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    map.insert(uint64_t{i} * 7919, i);
+  }
+  {
+    SnapshotWriter writer(path, "map");
+    map.save(writer);
+    ASSERT_TRUE(writer.commit());
+  }
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> loaded;
+  SnapshotReader reader(path, "map");
+  ASSERT_TRUE(loaded.load(reader));
+  EXPECT_TRUE(reader.atEnd());
+  EXPECT_EQ(loaded.size(), map.size());
+  EXPECT_EQ(loaded.capacity(), map.capacity());
+  for (uint32_t i = 0; i < 1000; ++i) {
+    ASSERT_NE(loaded.find(uint64_t{i} * 7919), nullptr);
+    EXPECT_EQ(*loaded.find(uint64_t{i} * 7919), i);
+  }
+  EXPECT_EQ(loaded.find(1), nullptr);
+  // It can still grow.
+  loaded.reserve(2000);
+  EXPECT_TRUE(loaded.insert(1, 1).second);
+}
+
+// A damaged capacity fails to load rather than being allocated.
+TEST(ConcurrentHash, LoadDamagedCapacity) {
+  const std::string path = testing::TempDir() + "/damaged_concurrent_hash";
+  ConcurrentFlatHashMap<uint64_t, uint32_t, KeyHash> map(10);
+  map.insert(1, 1);
+  {
+    SnapshotWriter writer(path, "map");
+    writer.write(size_t{1} << 60);
+    writer.write(map.size());
+    writer.writeBytes("slots", 5);
+    ASSERT_TRUE(writer.commit());
+  }
+  SnapshotReader reader(path, "map");
+  ASSERT_TRUE(reader.ok());
+  EXPECT_FALSE(map.load(reader));
+  EXPECT_TRUE(map.contains(1));
+}
@@ -0,0 +1,65 @@
+// Helpers for running code that is templated on board size against a puzzle
+// whose size is only known at runtime.
+//
+// Every size up to kMaxDimension x kMaxDimension is compiled into the binary
+// so solving a new puzzle never requires a rebuild. Boards larger than the app
+// supports can be handled by building with
+// --copt=-DLOOPINGDICE_MAX_DIMENSION=<n>, up to 16 since move_table.h numbers
+// cells with a byte.
+#ifndef LOOPINGDICE_DISPATCH
+#define LOOPINGDICE_DISPATCH
+
+#include <iostream>
+#include <utility>
+
+#include "board.h"
+#include "puzzle.h"
+
+#ifndef LOOPINGDICE_MAX_DIMENSION
+// The largest board the app can generate is 8x8.
+#define LOOPINGDICE_MAX_DIMENSION 8
+#endif
+
+constexpr std::size_t kMaxDimension = LOOPINGDICE_MAX_DIMENSION;
+static_assert(kMaxDimension >= 1 && kMaxDimension <= 16,
+              "LOOPINGDICE_MAX_DIMENSION must be between 1 and 16 since "
+              "Permutation numbers cells with a byte");
+
+// Exit code returned when a puzzle is too large for this binary.
+constexpr int kUnsupportedSize = 6;
+
+inline bool isSupportedSize(size_t num_rows, size_t num_cols) {
+  return num_rows >= 1 && num_rows <= kMaxDimension && num_cols >= 1 &&
+         num_cols <= kMaxDimension;
+}
+
+template <std::size_t num_rows, std::size_t num_cols, typename F>
+int invokeWithBoards(const Puzzle &puzzle, F &f) {
+  return f(toBoard<num_rows, num_cols>(puzzle.initial),
+           toBoard<num_rows, num_cols>(puzzle.win));
+}
+
+template <typename F, std::size_t... Is>
+int dispatchBySizeImpl(const Puzzle &puzzle, F &f,
+                       std::index_sequence<Is...>) {
+  using Fn = int (*)(const Puzzle &, F &);
+  static constexpr Fn table[] = {
+      &invokeWithBoards<Is / kMaxDimension + 1, Is % kMaxDimension + 1, F>...};
+  return table[(puzzle.num_rows - 1) * kMaxDimension + puzzle.num_cols - 1](
+      puzzle, f);
+}
+
+// Calls |f| with the puzzle's initial and win states converted to
+// Board<num_rows, num_cols> and returns whatever |f| returns. |f| is typically
+// a generic lambda that forwards to a function templated on board size.
+template <typename F> int dispatchBySize(const Puzzle &puzzle, F &&f) {
+  if (!isSupportedSize(puzzle.num_rows, puzzle.num_cols)) {
+    std::cout << "Boards larger than " << kMaxDimension << "x" << kMaxDimension
+              << " are not supported" << std::endl;
+    return kUnsupportedSize;
+  }
+  return dispatchBySizeImpl(
+      puzzle, f, std::make_index_sequence<kMaxDimension * kMaxDimension>());
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "dispatch.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+template <std::size_t num_rows, std::size_t num_cols>
+int encodeSize(const Board<num_rows, num_cols> &) {
+  return num_rows * 100 + num_cols;
+}
+
+Puzzle makePuzzle(size_t num_rows, size_t num_cols) {
+  Puzzle puzzle;
+  puzzle.num_rows = num_rows;
+  puzzle.num_cols = num_cols;
+  for (size_t i = 0; i < num_rows * num_cols; ++i) {
+    puzzle.initial.push_back(i);
+    puzzle.win.push_back(i);
+  }
+  return puzzle;
+}
+
+TEST(Dispatch, EverySize) {
+  for (size_t num_rows = 1; num_rows <= kMaxDimension; ++num_rows) {
+    for (size_t num_cols = 1; num_cols <= kMaxDimension; ++num_cols) {
+      EXPECT_EQ(dispatchBySize(makePuzzle(num_rows, num_cols),
+                               [](const auto &initial, const auto &) {
+                                 return encodeSize(initial);
+                               }),
+                num_rows * 100 + num_cols);
+    }
+  }
+}
+
+TEST(Dispatch, PassesBoards) {
+  Puzzle puzzle = makePuzzle(2, 3);
+  puzzle.win = {5, 4, 3, 2, 1, 0};
+  const Board<2, 3> expected_initial = {{
+      {{0, 1, 2}},
+      {{3, 4, 5}},
+  }};
+  const Board<2, 3> expected_win = {{
+      {{5, 4, 3}},
+      {{2, 1, 0}},
+  }};
+
+  dispatchBySize(puzzle, [&](const auto &initial, const auto &win) {
+    EXPECT_EQ(fromBoard(initial), fromBoard(expected_initial));
+    EXPECT_EQ(fromBoard(win), fromBoard(expected_win));
+    return 0;
+  });
+}
+
+TEST(Dispatch, UnsupportedSize) {
+  EXPECT_EQ(dispatchBySize(makePuzzle(kMaxDimension + 1, 2),
+                           [](const auto &, const auto &) {
+                             return 0;
+                           }),
+            kUnsupportedSize);
+}
@@ -3,10 +3,14 @@
 
 #include <array>
 #include <initializer_list>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
 
 // Defines the kinds of moves that are possible
 enum class Mode {
@@ -29,18 +33,18 @@ enum class Validation : int32_t {
   STATIC = 8
 };
 
-Validation operator|(Validation lhs, Validation rhs) {
+inline Validation operator|(Validation lhs, Validation rhs) {
   return static_cast<Validation>(static_cast<char>(lhs) |
                                  static_cast<char>(rhs));
 }
-Validation operator&(Validation lhs, Validation rhs) {
+inline Validation operator&(Validation lhs, Validation rhs) {
   return static_cast<Validation>(static_cast<char>(lhs) &
                                  static_cast<char>(rhs));
 }
 
 
 
-std::string modeToString(const Mode &mode) {
+inline std::string modeToString(const Mode &mode) {
   switch (mode) {
   case Mode::BASIC:
     return "WIDE 1";
@@ -62,7 +66,7 @@ std::string modeToString(const Mode &mode) {
   return "ERROR";
 }
 
-std::string validationToString(const Validation &validation) {
+inline std::string validationToString(const Validation &validation) {
   std::vector<std::string> ret;
 
   if ((validation & Validation::ARROWS) != Validation::NONE) {
@@ -85,7 +89,7 @@ std::string validationToString(const Validation &validation) {
   }
 }
 
-bool isCompatible(const Mode &horizontal, const Mode &vertical) {
+inline bool isCompatible(const Mode &horizontal, const Mode &vertical) {
   // For these modes, if either horizontal or vertical has them, the other ought
   // to as well.
   for (const Mode &m : {Mode::BANDAGED, Mode::LIGHTNING}) {
@@ -98,12 +102,52 @@ bool isCompatible(const Mode &horizontal, const Mode &vertical) {
   return true;
 }
 
-std::string modesToString(const Mode &horizontal, const Mode &vertical,
+inline std::string modesToString(const Mode &horizontal, const Mode &vertical,
                           const Validation &validation) {
   return modeToString(horizontal) + "|" + modeToString(vertical) + "|" +
          validationToString(validation);
 }
 
+// Inverse of modeToString. Also accepts "BASIC" since that's what most levels
+// in the app use.
+inline std::optional<Mode> parseMode(absl::string_view str) {
+  static const auto *modes = new std::unordered_map<std::string, Mode>({
+      {"BASIC", Mode::BASIC},
+      {"WIDE 1", Mode::WIDE_1},
+      {"WIDE 2", Mode::WIDE_2},
+      {"WIDE 3", Mode::WIDE_3},
+      {"WIDE 4", Mode::WIDE_4},
+      {"GEAR", Mode::GEAR},
+      {"CAROUSEL", Mode::CAROUSEL},
+      {"BANDAGED", Mode::BANDAGED},
+      {"LIGHTNING", Mode::LIGHTNING},
+  });
+  auto it = modes->find(std::string(str));
+  if (it == modes->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+// Inverse of validationToString.
+inline std::optional<Validation> parseValidation(absl::string_view str) {
+  Validation ret = Validation::NONE;
+  for (absl::string_view part : absl::StrSplit(str, '+')) {
+    if (part == "ARROWS") {
+      ret = ret | Validation::ARROWS;
+    } else if (part == "DYNAMIC") {
+      ret = ret | Validation::DYNAMIC;
+    } else if (part == "ENABLER") {
+      ret = ret | Validation::ENABLER;
+    } else if (part == "STATIC") {
+      ret = ret | Validation::STATIC;
+    } else if (part != "NONE") {
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 bool sameElements(std::array<std::array<int, num_cols>, num_rows> first,
                   std::array<std::array<int, num_cols>, num_rows> second) {
@@ -119,7 +163,22 @@ bool sameElements(std::array<std::array<int, num_cols>, num_rows> first,
   return elements_first == elements_second;
 }
 
-bool moveFits(const Mode &mode, size_t size) {
+// Same as above but for boards stored as flat, row-major lists of cells.
+inline bool sameElements(const std::vector<int> &first,
+                         const std::vector<int> &second) {
+  std::unordered_map<int, int> elements_first;
+  std::unordered_map<int, int> elements_second;
+  for (int cell : first) {
+    elements_first[cell] += 1;
+  }
+  for (int cell : second) {
+    elements_second[cell] += 1;
+  }
+
+  return elements_first == elements_second;
+}
+
+inline bool moveFits(const Mode &mode, size_t size) {
   if ((mode == Mode::WIDE_4 && size < 4) ||
       (mode == Mode::WIDE_3 && size < 3) ||
       (mode == Mode::WIDE_2 && size < 2) ||
@@ -48,3 +48,32 @@ TEST(Enums, MoveFits) {
   EXPECT_FALSE(moveFits(Mode::WIDE_1, 0));
   EXPECT_FALSE(moveFits(Mode::WIDE_4, 3));
 }
+
+TEST(Enums, ParseMode) {
+  for (Mode mode : {Mode::BASIC, Mode::WIDE_2, Mode::WIDE_3, Mode::WIDE_4,
+                    Mode::GEAR, Mode::CAROUSEL, Mode::BANDAGED,
+                    Mode::LIGHTNING}) {
+    EXPECT_EQ(parseMode(modeToString(mode)), mode);
+  }
+  EXPECT_EQ(parseMode("BASIC"), Mode::BASIC);
+  EXPECT_EQ(parseMode("WIDE 5"), std::nullopt);
+  EXPECT_EQ(parseMode(""), std::nullopt);
+}
+
+TEST(Enums, ParseValidation) {
+  EXPECT_EQ(parseValidation("NONE"), Validation::NONE);
+  EXPECT_EQ(parseValidation("STATIC"), Validation::STATIC);
+  EXPECT_EQ(parseValidation("ARROWS+DYNAMIC"),
+            Validation::ARROWS | Validation::DYNAMIC);
+  EXPECT_EQ(parseValidation(validationToString(Validation::ENABLER |
+                                               Validation::STATIC)),
+            Validation::ENABLER | Validation::STATIC);
+  EXPECT_EQ(parseValidation("ARROWS+BOGUS"), std::nullopt);
+}
+
+TEST(Enums, SameElementsFlat) {
+  EXPECT_TRUE(sameElements(std::vector<int>{1, 2, 3, 4},
+                           std::vector<int>{4, 3, 2, 1}));
+  EXPECT_FALSE(sameElements(std::vector<int>{1, 2, 3, 4},
+                            std::vector<int>{1, 1, 2, 3}));
+}
@@ -0,0 +1,408 @@
+// Breadth first search that keeps its layers on disk rather than in a visited
+// set, for puzzles with more states than fit in memory.
+//
+// Each layer is a file of sorted keys, stored as the varint encoded gaps
+// between them, which takes a byte or two per key for dense layers. A layer is
+// expanded by streaming through its file and collecting neighbors in a buffer
+// of bounded size. Whenever the buffer fills up it's sorted, deduplicated and
+// written out as a run in the same format. The runs are then merged into the
+// next layer, dropping keys that are also in earlier layers (delayed duplicate
+// detection).
+//
+// When every move can be undone, a neighbor of layer d is in layer d - 1, d or
+// d + 1, so only the last two layers need to be checked and older ones are
+// deleted. Otherwise every earlier layer is kept and checked.
+//
+// Keys must be unsigned integers, like those of PackedCodec.
+#ifndef LOOPINGDICE_EXTERNAL_BFS
+#define LOOPINGDICE_EXTERNAL_BFS
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "enums.h"
+#include "puzzle.h"
+
+// Whether the rules let every move be undone by another, so that the graph of
+// boards is undirected. Validation only looks at the cells of the lines that
+// move, and most moves keep those cells in those lines, so the inverse move
+// is allowed whenever the move was. Carousel moves pass cells between rows,
+// and their arrow and dynamic checks look at the corners and edges those
+// cells end up on, so they're taken to be one way to be safe.
+inline bool movesCanBeUndone(const Rules &rules) {
+  bool carousel =
+      rules.row_mode == Mode::CAROUSEL || rules.col_mode == Mode::CAROUSEL;
+  return !carousel ||
+         (rules.validation & (Validation::ARROWS | Validation::DYNAMIC)) ==
+             Validation::NONE;
+}
+
+// Writes sorted keys to a file as varint encoded gaps.
+template <typename Key> class RunWriter {
+public:
+  // Check ok() before writing.
+  explicit RunWriter(const std::string &path)
+      : file_(std::fopen(path.c_str(), "wb")) {
+    buffer_.reserve(kBufferSize);
+  }
+  ~RunWriter() { close(); }
+  RunWriter(const RunWriter &) = delete;
+  RunWriter &operator=(const RunWriter &) = delete;
+
+  bool ok() const { return file_ && ok_; }
+
+  // |key| must be larger than the last key written.
+  void write(const Key &key) {
+    Key gap = key - last_;
+    last_ = key;
+    while (gap > 0x7f) {
+      buffer_.push_back(static_cast<uint8_t>(gap) | 0x80);
+      gap >>= 7;
+    }
+    buffer_.push_back(static_cast<uint8_t>(gap));
+    if (buffer_.size() + kMaxVarintSize > kBufferSize) {
+      flush();
+    }
+  }
+
+  // Returns whether everything was written.
+  bool close() {
+    if (file_) {
+      flush();
+      ok_ = std::fclose(file_) == 0 && ok_;
+      file_ = nullptr;
+    }
+    return ok_;
+  }
+
+private:
+  static constexpr size_t kBufferSize = 1 << 16;
+  static constexpr size_t kMaxVarintSize = (sizeof(Key) * 8 + 6) / 7;
+
+  void flush() {
+    ok_ = ok_ && std::fwrite(buffer_.data(), 1, buffer_.size(), file_) ==
+                     buffer_.size();
+    buffer_.clear();
+  }
+
+  std::FILE *file_;
+  bool ok_ = true;
+  std::vector<uint8_t> buffer_;
+  Key last_ = 0;
+};
+
+// Reads back the keys written by a RunWriter, in order.
+template <typename Key> class RunReader {
+public:
+  // Check ok() before reading.
+  explicit RunReader(const std::string &path)
+      : file_(std::fopen(path.c_str(), "rb")), buffer_(kBufferSize) {}
+  ~RunReader() {
+    if (file_) {
+      std::fclose(file_);
+    }
+  }
+  RunReader(const RunReader &) = delete;
+  RunReader &operator=(const RunReader &) = delete;
+
+  // False if the file couldn't be opened or read, or ended mid key.
+  bool ok() const { return file_ && ok_; }
+
+  // Reads the next key into |key|. Returns false at the end of the file.
+  bool next(Key &key) {
+    Key gap = 0;
+    for (int shift = 0;; shift += 7) {
+      if (begin_ == end_ && !fill()) {
+        ok_ = ok_ && shift == 0;
+        return false;
+      }
+      uint8_t byte = buffer_[begin_++];
+      gap |= Key(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    last_ += gap;
+    key = last_;
+    return true;
+  }
+
+private:
+  static constexpr size_t kBufferSize = 1 << 16;
+
+  bool fill() {
+    if (!file_) {
+      return false;
+    }
+    begin_ = 0;
+    end_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    ok_ = ok_ && !std::ferror(file_);
+    return end_ > 0;
+  }
+
+  std::FILE *file_;
+  bool ok_ = true;
+  std::vector<uint8_t> buffer_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  Key last_ = 0;
+};
+
+template <typename Key> class ExternalBfs {
+public:
+  // Files are written to |dir|, which must exist, and removed when they're no
+  // longer needed. At most |max_memory| bytes of neighbors are held at once.
+  // |reversible| says whether every move can be undone; see
+  // movesCanBeUndone.
+  ExternalBfs(std::string dir, size_t max_memory, bool reversible)
+      : dir_(std::move(dir)),
+        buffer_size_(std::max<size_t>(1, max_memory / sizeof(Key))),
+        reversible_(reversible) {}
+  ~ExternalBfs() {
+    for (size_t depth = first_kept_; depth < layer_sizes_.size(); ++depth) {
+      std::remove(layerPath(depth).c_str());
+    }
+  }
+  ExternalBfs(const ExternalBfs &) = delete;
+  ExternalBfs &operator=(const ExternalBfs &) = delete;
+
+  // Makes |root| the first layer. Returns false if it couldn't be written.
+  bool start(const Key &root) {
+    RunWriter<Key> writer(layerPath(0));
+    if (!writer.ok()) {
+      return false;
+    }
+    writer.write(root);
+    if (!writer.close()) {
+      return false;
+    }
+    layer_sizes_ = {1};
+    bytes_on_disk_ = peak_bytes_on_disk_ = fileSize(layerPath(0));
+    return true;
+  }
+
+  // Number of keys in each layer found so far. The last one is the frontier.
+  const std::vector<uint64_t> &layerSizes() const { return layer_sizes_; }
+  bool done() const { return layer_sizes_.empty() || layer_sizes_.back() == 0; }
+  size_t peakBytesOnDisk() const { return peak_bytes_on_disk_; }
+
+  // Calls f(key) for each key in the frontier, in order. Returns false if it
+  // couldn't be read.
+  template <typename F> bool forEachInFrontier(const F &f) const {
+    RunReader<Key> reader(layerPath(layer_sizes_.size() - 1));
+    Key key;
+    while (reader.next(key)) {
+      f(key);
+    }
+    return reader.ok();
+  }
+
+  // Finds the next layer from the frontier. neighbors(key) returns a
+  // std::array of the keys reached by each move, giving back |key| for moves
+  // that are skipped or not allowed, as for LayeredSearch. Returns false if a
+  // file couldn't be read or written, after which the search can't go on.
+  template <typename Neighbors> bool expandLayer(const Neighbors &neighbors) {
+    size_t depth = layer_sizes_.size();
+    std::vector<std::string> runs;
+    std::vector<Key> buffer;
+    buffer.reserve(buffer_size_);
+    bool ok = true;
+    bool read = forEachInFrontier([&](const Key &key) {
+      for (const Key &next : neighbors(key)) {
+        if (next == key) {
+          continue;
+        }
+        buffer.push_back(next);
+        if (buffer.size() == buffer_size_) {
+          ok = writeRun(buffer, runs) && ok;
+        }
+      }
+    });
+    ok = ok && read && writeRun(buffer, runs);
+    std::vector<Key>().swap(buffer);
+    ok = ok && mergeRuns(runs, depth);
+    for (const std::string &run : runs) {
+      removeFile(run);
+    }
+    if (!ok) {
+      return false;
+    }
+    if (reversible_) {
+      for (; first_kept_ + 2 < layer_sizes_.size(); ++first_kept_) {
+        removeFile(layerPath(first_kept_));
+      }
+    }
+    return true;
+  }
+
+private:
+  // The most runs merged at once, which bounds the number of open files and
+  // the memory taken by their buffers.
+  static constexpr size_t kMaxMergeWidth = 256;
+
+  std::string layerPath(size_t depth) const {
+    return dir_ + "/layer_" + std::to_string(depth);
+  }
+
+  std::string runPath(size_t run) const {
+    return dir_ + "/run_" + std::to_string(run);
+  }
+
+  static size_t fileSize(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      return 0;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    return size < 0 ? 0 : size;
+  }
+
+  void addFile(const std::string &path) {
+    bytes_on_disk_ += fileSize(path);
+    peak_bytes_on_disk_ = std::max(peak_bytes_on_disk_, bytes_on_disk_);
+  }
+
+  void removeFile(const std::string &path) {
+    bytes_on_disk_ -= std::min(bytes_on_disk_, fileSize(path));
+    std::remove(path.c_str());
+  }
+
+  // Sorts |buffer| into a new run, adds it to |runs| and empties |buffer|.
+  bool writeRun(std::vector<Key> &buffer, std::vector<std::string> &runs) {
+    if (buffer.empty()) {
+      return true;
+    }
+    std::sort(buffer.begin(), buffer.end());
+    buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+    runs.push_back(runPath(next_run_++));
+    RunWriter<Key> writer(runs.back());
+    for (const Key &key : buffer) {
+      writer.write(key);
+    }
+    buffer.clear();
+    bool ok = writer.close();
+    addFile(runs.back());
+    return ok;
+  }
+
+  // Merges |inputs| into |output|, keeping one copy of each key and dropping
+  // keys that |exclude| returns true for. |exclude| is called with keys in
+  // increasing order. Returns the number of keys written, or nullopt on
+  // error.
+  template <typename Exclude>
+  std::optional<uint64_t> merge(const std::vector<std::string> &inputs,
+                                const std::string &output,
+                                const Exclude &exclude) {
+    std::vector<std::unique_ptr<RunReader<Key>>> readers;
+    using Head = std::pair<Key, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (const std::string &input : inputs) {
+      readers.push_back(std::make_unique<RunReader<Key>>(input));
+      Key key;
+      if (readers.back()->next(key)) {
+        heads.emplace(key, readers.size() - 1);
+      }
+    }
+    RunWriter<Key> writer(output);
+    uint64_t count = 0;
+    bool first = true;
+    Key last = 0;
+    while (!heads.empty()) {
+      auto [key, reader] = heads.top();
+      heads.pop();
+      Key next;
+      if (readers[reader]->next(next)) {
+        heads.emplace(next, reader);
+      }
+      if ((first || key != last) && !exclude(key)) {
+        writer.write(key);
+        ++count;
+      }
+      first = false;
+      last = key;
+    }
+    bool ok = writer.close();
+    for (const auto &reader : readers) {
+      ok = ok && reader->ok();
+    }
+    addFile(output);
+    if (!ok) {
+      return std::nullopt;
+    }
+    return count;
+  }
+
+  // Merges |runs| into layer |depth|, without the keys of earlier layers.
+  bool mergeRuns(std::vector<std::string> &runs, size_t depth) {
+    // Merge in passes until the runs can be merged at once.
+    while (runs.size() > kMaxMergeWidth) {
+      std::vector<std::string> inputs(runs.begin(),
+                                      runs.begin() + kMaxMergeWidth);
+      runs.erase(runs.begin(), runs.begin() + kMaxMergeWidth);
+      runs.push_back(runPath(next_run_++));
+      bool ok = merge(inputs, runs.back(), [](const Key &) { return false; })
+                    .has_value();
+      for (const std::string &input : inputs) {
+        removeFile(input);
+      }
+      if (!ok) {
+        return false;
+      }
+    }
+
+    // Earlier layers are sorted too, so each is walked once alongside the
+    // merge.
+    std::vector<std::unique_ptr<RunReader<Key>>> earlier;
+    std::vector<std::pair<bool, Key>> heads;
+    for (size_t layer = first_kept_; layer < depth; ++layer) {
+      earlier.push_back(std::make_unique<RunReader<Key>>(layerPath(layer)));
+      heads.emplace_back();
+      heads.back().first = earlier.back()->next(heads.back().second);
+    }
+    std::optional<uint64_t> count =
+        merge(runs, layerPath(depth), [&](const Key &key) {
+          bool found = false;
+          for (size_t i = 0; i < earlier.size(); ++i) {
+            auto &[more, head] = heads[i];
+            while (more && head < key) {
+              more = earlier[i]->next(head);
+            }
+            found = found || (more && head == key);
+          }
+          return found;
+        });
+    for (const auto &reader : earlier) {
+      if (!reader->ok()) {
+        return false;
+      }
+    }
+    if (!count) {
+      return false;
+    }
+    layer_sizes_.push_back(*count);
+    return true;
+  }
+
+  std::string dir_;
+  size_t buffer_size_;
+  bool reversible_;
+  std::vector<uint64_t> layer_sizes_;
+  // Layers before this one have been deleted.
+  size_t first_kept_ = 0;
+  size_t next_run_ = 0;
+  size_t bytes_on_disk_ = 0;
+  size_t peak_bytes_on_disk_ = 0;
+};
+
+#endif
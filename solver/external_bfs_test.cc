@@ -0,0 +1,142 @@
+#include "external_bfs.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "layered_search.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "packed_board.h"
+
+namespace {
+
+// The same graph as in layered_search_test.cc. Multiplying can't be undone.
+constexpr uint64_t kSize = 1000003;
+
+std::array<uint64_t, 4> neighbors(uint64_t key) {
+  return {(key * 3) % kSize, (key * 7 + 1) % kSize, (key + 1) % kSize,
+          (key + kSize - 1) % kSize};
+}
+
+// A torus, on which every step can be undone.
+constexpr uint64_t kWidth = 300;
+
+std::array<uint64_t, 4> torusNeighbors(uint64_t key) {
+  uint64_t x = key % kWidth;
+  uint64_t y = key / kWidth;
+  uint64_t left = (x + kWidth - 1) % kWidth;
+  uint64_t up = (y + kWidth - 1) % kWidth;
+  return {y * kWidth + (x + 1) % kWidth, y * kWidth + left,
+          (y + 1) % kWidth * kWidth + x, up * kWidth + x};
+}
+
+// Number of keys LayeredSearch finds at each depth, ending with an empty
+// layer like ExternalBfs.
+template <typename Key, typename Neighbors>
+std::vector<uint64_t> layerSizes(const Key &root, const Neighbors &neighbors) {
+  LayeredSearch<Key> search(root, 0);
+  std::vector<uint64_t> ret;
+  while (!search.done()) {
+    ret.push_back(search.frontierSize());
+    search.expandLayer(neighbors, false);
+  }
+  ret.push_back(0);
+  return ret;
+}
+
+} // namespace
+
+TEST(RunWriter, RoundTrip) {
+  const std::string path = testing::TempDir() + "/run";
+  const std::vector<absl::uint128> keys = {
+      0, 1, 127, 128, 300, absl::MakeUint128(1, 0),
+      absl::MakeUint128(~uint64_t{0}, ~uint64_t{0})};
+  {
+    RunWriter<absl::uint128> writer(path);
+    ASSERT_TRUE(writer.ok());
+    for (const auto &key : keys) {
+      writer.write(key);
+    }
+    EXPECT_TRUE(writer.close());
+  }
+  RunReader<absl::uint128> reader(path);
+  std::vector<absl::uint128> read;
+  absl::uint128 key;
+  while (reader.next(key)) {
+    read.push_back(key);
+  }
+  EXPECT_TRUE(reader.ok());
+  EXPECT_EQ(read, keys);
+}
+
+TEST(RunReader, MissingFile) {
+  RunReader<uint64_t> reader(testing::TempDir() + "/no_such_run");
+  uint64_t key;
+  EXPECT_FALSE(reader.next(key));
+  EXPECT_FALSE(reader.ok());
+}
+
+// Small buffers make many runs, which take several passes to merge.
+TEST(ExternalBfs, MatchesLayeredSearch) {
+  const std::vector<uint64_t> expected =
+      layerSizes(uint64_t{1}, torusNeighbors);
+  for (size_t max_memory : {size_t{1} << 30, size_t{1} << 10}) {
+    for (bool reversible : {true, false}) {
+      ExternalBfs<uint64_t> search(testing::TempDir(), max_memory, reversible);
+      ASSERT_TRUE(search.start(1));
+      while (!search.done()) {
+        ASSERT_TRUE(search.expandLayer(torusNeighbors));
+      }
+      EXPECT_EQ(search.layerSizes(), expected);
+      EXPECT_GT(search.peakBytesOnDisk(), 0);
+    }
+  }
+}
+
+TEST(ExternalBfs, OneWayMoves) {
+  ExternalBfs<uint64_t> search(testing::TempDir(), 1 << 20, false);
+  ASSERT_TRUE(search.start(1));
+  while (!search.done()) {
+    ASSERT_TRUE(search.expandLayer(neighbors));
+  }
+  EXPECT_EQ(search.layerSizes(), layerSizes(uint64_t{1}, neighbors));
+}
+
+// Includes rules whose moves can't all be undone, for which dropping only the
+// last two layers' keys would find some boards again.
+TEST(ExternalBfs, Puzzles) {
+  const Board<3, 3> initial = {{
+      {{1, 1 | FIXED, 2}},
+      {{2 | ENABLER, 3, 3}},
+      {{1, 2, 3 | HORIZ}},
+  }};
+  CellAlphabet alphabet(fromBoard(initial));
+  PackedCodec<3, 3, uint64_t> codec(alphabet);
+  for (const Rules &rules :
+       {Rules{Mode::BASIC, Mode::BASIC, Validation::DYNAMIC},
+        Rules{Mode::GEAR, Mode::WIDE_2, Validation::ARROWS},
+        Rules{Mode::CAROUSEL, Mode::CAROUSEL,
+              Validation::ARROWS | Validation::DYNAMIC},
+        Rules{Mode::LIGHTNING, Mode::BANDAGED, Validation::ENABLER}}) {
+    MoveTable<3, 3> moves(rules);
+    MovePruning<3, 3> pruning(moves);
+    auto neighbors = [&](const uint64_t &key) {
+      return exploreNeighbors(codec.decode(key), key, -1, moves, pruning,
+                              codec);
+    };
+    ExternalBfs<uint64_t> search(testing::TempDir(), 1 << 10,
+                                 movesCanBeUndone(rules));
+    ASSERT_TRUE(search.start(codec.encode(initial)));
+    while (!search.done()) {
+      ASSERT_TRUE(search.expandLayer(neighbors));
+    }
+    EXPECT_EQ(search.layerSizes(),
+              layerSizes(codec.encode(initial), neighbors))
+        << modesToString(rules.row_mode, rules.col_mode, rules.validation);
+  }
+}
@@ -6,11 +6,12 @@
 #include "board.h"
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateGearRowMove(const Board<num_rows, num_cols> &board, int offset,
+bool validateGearRowMove(const Board<num_rows, num_cols> &board,
+                         const LineFlags<num_rows, num_cols> &lines, int offset,
                          bool forward, const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (row_contains_fixed_cell(board, offset) ||
-        (row_contains_fixed_cell(board, offset + 1))) {
+    if (row_contains_fixed_cell(lines, offset) ||
+        (row_contains_fixed_cell(lines, offset + 1))) {
       return false;
     }
   }
@@ -21,14 +22,14 @@ bool validateGearRowMove(const Board<num_rows, num_cols> &board, int offset,
     }
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
-    if (row_contains_arrows_cell(board, offset) ||
-        row_contains_arrows_cell(board, offset + 1)) {
+    if (row_contains_arrows_cell(lines, offset) ||
+        row_contains_arrows_cell(lines, offset + 1)) {
       return false;
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!row_contains_enabler(board, offset) &&
-        !row_contains_enabler(board, offset + 1)) {
+    if (!row_contains_enabler(lines, offset) &&
+        !row_contains_enabler(lines, offset + 1)) {
       return false;
     }
   }
@@ -36,6 +37,13 @@ bool validateGearRowMove(const Board<num_rows, num_cols> &board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateGearRowMove(const Board<num_rows, num_cols> &board, int offset,
+                         bool forward, const Validation &validation) {
+  return validateGearRowMove(board, LineFlags<num_rows, num_cols>(board),
+                             offset, forward, validation);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> gearRowMove(Board<num_rows, num_cols> board,
                                       int offset, bool forward,
@@ -50,11 +58,12 @@ Board<num_rows, num_cols> gearRowMove(Board<num_rows, num_cols> board,
 }
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateGearColMove(const Board<num_rows, num_cols> &board, int offset,
+bool validateGearColMove(const Board<num_rows, num_cols> &board,
+                         const LineFlags<num_rows, num_cols> &lines, int offset,
                          bool forward, const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (col_contains_fixed_cell(board, offset) ||
-        (col_contains_fixed_cell(board, offset + 1))) {
+    if (col_contains_fixed_cell(lines, offset) ||
+        (col_contains_fixed_cell(lines, offset + 1))) {
       return false;
     }
   }
@@ -65,14 +74,14 @@ bool validateGearColMove(const Board<num_rows, num_cols> &board, int offset,
     }
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
-    if (col_contains_arrows_cell(board, offset) ||
-        col_contains_arrows_cell(board, offset + 1)) {
+    if (col_contains_arrows_cell(lines, offset) ||
+        col_contains_arrows_cell(lines, offset + 1)) {
       return false;
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!col_contains_enabler(board, offset) &&
-        !col_contains_enabler(board, offset + 1)) {
+    if (!col_contains_enabler(lines, offset) &&
+        !col_contains_enabler(lines, offset + 1)) {
       return false;
     }
   }
@@ -80,6 +89,13 @@ bool validateGearColMove(const Board<num_rows, num_cols> &board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateGearColMove(const Board<num_rows, num_cols> &board, int offset,
+                         bool forward, const Validation &validation) {
+  return validateGearColMove(board, LineFlags<num_rows, num_cols>(board),
+                             offset, forward, validation);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> gearColMove(Board<num_rows, num_cols> board,
                                       int offset, bool forward,
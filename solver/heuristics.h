@@ -0,0 +1,124 @@
+// Lower bounds on the number of moves needed to solve a board, for guiding
+// searches like IDA*.
+//
+// A heuristic is any class with
+//   int operator()(const Board<num_rows, num_cols>& board) const;
+// that never returns more than the length of a shortest path from |board| to
+// the goal it was built for, and returns kUnsolvable if there isn't one.
+#ifndef LOOPINGDICE_HEURISTICS
+#define LOOPINGDICE_HEURISTICS
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include "board.h"
+#include "move_table.h"
+
+// Bound for boards that can't reach the goal.
+constexpr int kUnsolvable = std::numeric_limits<int>::max();
+
+// Knows nothing. Turns IDA* into plain iterative deepening.
+template <std::size_t num_rows, std::size_t num_cols> struct ZeroHeuristic {
+  int operator()(const Board<num_rows, num_cols> &) const { return 0; }
+};
+
+// Bounds how far each cell is from the nearest place in the goal with the
+// same value.
+//
+// The distance between two places is the fewest moves that could carry a cell
+// from one to the other, found from every permutation in the move table rather
+// than worked out per mode. So it's the distance around the torus for BASIC
+// and WIDE_n, and also accounts for cells hopping between rows in CAROUSEL,
+// the row dragged along in GEAR, double slides in LIGHTNING and the extra rows
+// a BANDAGED move can take with it. Validation is ignored, which can only make
+// moves look cheaper.
+//
+// A move carries each cell at most one step, so the furthest cell is a bound.
+// So is the total distance divided by the most cells a move can carry.
+template <std::size_t num_rows, std::size_t num_cols>
+class CellDistanceHeuristic {
+public:
+  static constexpr size_t kNumCells = num_rows * num_cols;
+
+  CellDistanceHeuristic(const Board<num_rows, num_cols> &win,
+                        const MoveTable<num_rows, num_cols> &moves) {
+    // Each permutation moves a cell from from[i] to to[i] in one step.
+    std::array<std::vector<uint8_t>, kNumCells> steps;
+    moves.forEachPermutation(
+        [&](const Permutation<num_rows, num_cols> &permutation, bool) {
+          max_moved_ = std::max<int>(max_moved_, permutation.size);
+          for (size_t i = 0; i < permutation.size; ++i) {
+            steps[permutation.from[i]].push_back(permutation.to[i]);
+          }
+        });
+
+    std::array<std::array<int, kNumCells>, kNumCells> distances;
+    for (size_t source = 0; source < kNumCells; ++source) {
+      distances[source].fill(kUnsolvable);
+      distances[source][source] = 0;
+      std::queue<uint8_t> q;
+      q.push(source);
+      while (!q.empty()) {
+        uint8_t cell = q.front();
+        q.pop();
+        for (uint8_t next : steps[cell]) {
+          if (distances[source][next] == kUnsolvable) {
+            distances[source][next] = distances[source][cell] + 1;
+            q.push(next);
+          }
+        }
+      }
+    }
+
+    for (size_t goal = 0; goal < kNumCells; ++goal) {
+      int value = win[goal / num_cols][goal % num_cols];
+      auto it = std::find(values_.begin(), values_.end(), value);
+      if (it == values_.end()) {
+        values_.push_back(value);
+        to_goal_.emplace_back();
+        to_goal_.back().fill(kUnsolvable);
+        it = values_.end() - 1;
+      }
+      auto &to_goal = to_goal_[it - values_.begin()];
+      for (size_t cell = 0; cell < kNumCells; ++cell) {
+        to_goal[cell] = std::min(to_goal[cell], distances[cell][goal]);
+      }
+    }
+  }
+
+  int operator()(const Board<num_rows, num_cols> &board) const {
+    int furthest = 0;
+    int total = 0;
+    for (size_t cell = 0; cell < kNumCells; ++cell) {
+      int value = board[cell / num_cols][cell % num_cols];
+      auto it = std::find(values_.begin(), values_.end(), value);
+      if (it == values_.end()) {
+        return kUnsolvable;
+      }
+      int distance = to_goal_[it - values_.begin()][cell];
+      if (distance == kUnsolvable) {
+        return kUnsolvable;
+      }
+      furthest = std::max(furthest, distance);
+      total += distance;
+    }
+    if (max_moved_ == 0) {
+      return total == 0 ? 0 : kUnsolvable;
+    }
+    return std::max(furthest, (total + max_moved_ - 1) / max_moved_);
+  }
+
+private:
+  // The distinct values in the goal, and for each, how far each place is from
+  // the nearest place in the goal with that value.
+  std::vector<int> values_;
+  std::vector<std::array<int, kNumCells>> to_goal_;
+  // The most cells any one move changes.
+  int max_moved_ = 0;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "heuristics.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ida_star.h"
+#include "move_table.h"
+
+TEST(Heuristics, CellDistanceOnTorus) {
+  const Board<3, 4> win = {{
+      {{1, 0, 0, 0}},
+      {{0, 0, 0, 0}},
+      {{0, 0, 0, 0}},
+  }};
+  MoveTable<3, 4> moves(Rules{Mode::BASIC, Mode::BASIC, Validation::NONE});
+  CellDistanceHeuristic<3, 4> heuristic(win, moves);
+  EXPECT_EQ(heuristic(win), 0);
+
+  // Moving the 1 from the middle back to the corner takes one row move and
+  // one column move.
+  Board<3, 4> board = win;
+  std::swap(board[0][0], board[1][1]);
+  EXPECT_EQ(heuristic(board), 2);
+  // Wrapping around is shorter.
+  std::swap(board[1][1], board[2][3]);
+  EXPECT_EQ(heuristic(board), 2);
+
+  // A value that isn't in the goal can't be fixed.
+  board[0][0] = 2;
+  EXPECT_EQ(heuristic(board), kUnsolvable);
+}
+
+TEST(Heuristics, CellDistanceCountsWideMoves) {
+  const Board<4, 4> win = {{
+      {{1, 1, 1, 1}},
+      {{1, 1, 1, 1}},
+      {{2, 2, 2, 2}},
+      {{2, 2, 2, 2}},
+  }};
+  const Board<4, 4> board = {{
+      {{2, 2, 2, 2}},
+      {{2, 2, 2, 2}},
+      {{1, 1, 1, 1}},
+      {{1, 1, 1, 1}},
+  }};
+  // Every cell is a step from a cell of its color, wrapping around. Column
+  // moves carry 4 cells, so 16 cells take at least 4 moves.
+  MoveTable<4, 4> basic(Rules{Mode::BASIC, Mode::BASIC, Validation::NONE});
+  EXPECT_EQ((CellDistanceHeuristic<4, 4>(win, basic)(board)), 4);
+  // Wide column moves carry twice as many.
+  MoveTable<4, 4> wide(Rules{Mode::BASIC, Mode::WIDE_2, Validation::NONE});
+  EXPECT_EQ((CellDistanceHeuristic<4, 4>(win, wide)(board)), 2);
+}
+
+// A board with a few colors and every kind of flag sprinkled around.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> randomBoard(std::mt19937 &rng) {
+  const int flags[] = {HORIZ, VERT,      UP,    DOWN,   LEFT,
+                       RIGHT, LIGHTNING, FIXED, ENABLER};
+  Board<num_rows, num_cols> board;
+  for (auto &row : board) {
+    for (int &cell : row) {
+      cell = rng() % 3;
+      for (int flag : flags) {
+        if (rng() % 8 == 0) {
+          cell |= flag;
+        }
+      }
+    }
+  }
+  return board;
+}
+
+// Checks that the heuristic never overestimates, against exhaustive iterative
+// deepening, for short random walks in every mode and validation.
+TEST(Heuristics, CellDistanceIsAdmissible) {
+  const Mode modes[] = {Mode::BASIC,  Mode::WIDE_2,   Mode::GEAR,
+                        Mode::CAROUSEL, Mode::BANDAGED, Mode::LIGHTNING};
+  constexpr int kMaxWalk = 2;
+  std::mt19937 rng(1);
+  for (Mode row_mode : modes) {
+    for (Mode col_mode : modes) {
+      for (int validation = 0; validation < 16; ++validation) {
+        Rules rules{row_mode, col_mode, static_cast<Validation>(validation)};
+        MoveTable<3, 3> moves(rules);
+        Board<3, 3> win = randomBoard<3, 3>(rng);
+        CellDistanceHeuristic<3, 3> heuristic(win, moves);
+        Board<3, 3> board = win;
+        for (int i = 0; i < kMaxWalk; ++i) {
+          board = moves.rowMove(board, rng() % 3, rng() % 2);
+          board = moves.colMove(board, rng() % 3, rng() % 2);
+        }
+        IdaStarResult exact = solveIdaStar(board, win, moves,
+                                           ZeroHeuristic<3, 3>(), 2 * kMaxWalk);
+        ASSERT_TRUE(exact.solved);
+        EXPECT_LE(heuristic(board), exact.path.size())
+            << modeToString(row_mode) << " " << modeToString(col_mode) << " "
+            << validation;
+      }
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_join.h"
+#include "board.h"
+#include "dispatch.h"
+#include "enums.h"
+#include "heuristics.h"
+#include "ida_star.h"
+#include "move_table.h"
+#include "pattern_database.h"
+#include "puzzle.h"
+#include "puzzle_flags.h"
+
+ABSL_FLAG(int, max_depth, 100, "Longest solution to search for");
+ABSL_FLAG(std::string, heuristic, "cell_distance",
+          "Lower bound to guide the search with: cell_distance, pdb, "
+          "additive_pdb or none. pdb builds pattern databases over groups of "
+          "the goal's values; additive_pdb builds two per group, counting row "
+          "and column moves separately, and adds them.");
+ABSL_FLAG(double, pdb_max_entries, 1e7,
+          "Largest pattern database to build, in entries of one byte each");
+
+// Exit code returned when --heuristic isn't recognized.
+constexpr int kUnknownHeuristic = 8;
+
+void printSolution(const std::vector<std::string>& path) {
+  std::cout << "# "
+    << absl::StrJoin(path, ",")
+    << " (" << path.size() << ")"
+    << std::endl;
+}
+
+// Searches with the largest of |cell_distance| and a Database for each group
+// of values in the goal.
+template<typename Database, std::size_t num_rows, std::size_t num_cols>
+IdaStarResult solveWithDatabases(
+    const Board<num_rows, num_cols>& initial,
+    const Board<num_rows, num_cols>& win,
+    const MoveTable<num_rows, num_cols>& moves,
+    const CellDistanceHeuristic<num_rows, num_cols>& cell_distance,
+    int max_depth) {
+  std::vector<Database> databases;
+  for (const Abstraction& abstraction :
+       partitionValues(win, absl::GetFlag(FLAGS_pdb_max_entries))) {
+    databases.emplace_back(win, moves, abstraction);
+  }
+  auto heuristic = [&](const Board<num_rows, num_cols>& board) {
+    int ret = cell_distance(board);
+    for (const Database& database : databases) {
+      ret = std::max(ret, database(board));
+    }
+    return ret;
+  };
+  return solveIdaStar(initial, win, moves, heuristic, max_depth);
+}
+
+template<std::size_t num_rows, std::size_t num_cols>
+IdaStarResult solve(const Board<num_rows, num_cols>& initial,
+                    const Board<num_rows, num_cols>& win, const Rules& rules,
+                    const std::string& heuristic, int max_depth) {
+  MoveTable<num_rows, num_cols> moves(rules);
+  if (heuristic == "none") {
+    return solveIdaStar(initial, win, moves,
+                        ZeroHeuristic<num_rows, num_cols>(), max_depth);
+  }
+  CellDistanceHeuristic<num_rows, num_cols> cell_distance(win, moves);
+  if (heuristic == "cell_distance") {
+    return solveIdaStar(initial, win, moves, cell_distance, max_depth);
+  }
+  return heuristic == "pdb"
+             ? solveWithDatabases<PatternDatabase<num_rows, num_cols>>(
+                   initial, win, moves, cell_distance, max_depth)
+             : solveWithDatabases<AdditivePatternDatabase<num_rows, num_cols>>(
+                   initial, win, moves, cell_distance, max_depth);
+}
+
+int main (int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<Puzzle> puzzle = puzzleFromFlags();
+  if (!puzzle) {
+    return 7;
+  }
+  if (int error = checkPuzzle(*puzzle)) {
+    return error;
+  }
+  const std::string heuristic = absl::GetFlag(FLAGS_heuristic);
+  if (heuristic != "cell_distance" && heuristic != "pdb" &&
+      heuristic != "additive_pdb" && heuristic != "none") {
+    std::cout << "Unknown heuristic " << heuristic << std::endl;
+    return kUnknownHeuristic;
+  }
+
+  return dispatchBySize(*puzzle, [&](const auto& initial, const auto& win) {
+    std::cout << puzzle->num_rows << std::endl
+      << puzzle->num_cols << std::endl
+      << modesToString(puzzle->rules.row_mode, puzzle->rules.col_mode,
+                       puzzle->rules.validation) << std::endl
+      << boardToString(initial, puzzle->rules.row_mode, ",") << std::endl
+      << boardToString(win, puzzle->rules.row_mode, ",") << std::endl;
+
+    IdaStarResult result = solve(initial, win, puzzle->rules, heuristic,
+                                 absl::GetFlag(FLAGS_max_depth));
+    if (result.solved) {
+      printSolution(result.path);
+    } else if (result.lower_bound) {
+      std::cout << "# Gave up past --max_depth; no solution is shorter than "
+                << result.lower_bound << " moves" << std::endl;
+      return 11;
+    }
+    return 0;
+  });
+}
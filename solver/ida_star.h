@@ -0,0 +1,156 @@
+// Iterative deepening A* search for an optimal path between two boards.
+//
+// Unlike mitm, which keeps every state it reaches, this only holds the path
+// it's currently on, so memory grows with the solution's length rather than
+// the state space. In exchange states are revisited, both across iterations
+// and through transpositions within one, so it relies on a good heuristic
+// from heuristics.h to keep the number of states expanded down.
+#ifndef LOOPINGDICE_IDA_STAR
+#define LOOPINGDICE_IDA_STAR
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+#include "heuristics.h"
+#include "move_pruning.h"
+#include "move_table.h"
+
+// The outcome of a search. |path| is in the notation the app accepts, e.g.
+// {"R0", "C2'"}.
+struct IdaStarResult {
+  bool solved = false;
+  std::vector<std::string> path;
+  // Number of boards whose neighbors were generated, over all iterations.
+  size_t states_expanded = 0;
+  // Number of depth first searches run, each with a higher bound.
+  int iterations = 0;
+  // If the search gave up past its maximum depth, the length no path can be
+  // shorter than. Otherwise 0, so an unsolved result with a 0 lower bound
+  // means there's no path at all.
+  int lower_bound = 0;
+};
+
+template <std::size_t num_rows, std::size_t num_cols, typename Heuristic>
+class IdaStar {
+public:
+  IdaStar(const Board<num_rows, num_cols> &win,
+          const MoveTable<num_rows, num_cols> &moves,
+          const Heuristic &heuristic)
+      : win_(win), moves_(moves), pruning_(moves), heuristic_(heuristic) {}
+
+  // Searches for paths of at most |max_depth| moves.
+  IdaStarResult solve(const Board<num_rows, num_cols> &initial,
+                      int max_depth) {
+    result_ = IdaStarResult();
+    boards_ = {initial};
+    path_.clear();
+    int bound = heuristic_(initial);
+    while (bound <= max_depth) {
+      ++result_.iterations;
+      int next_bound = search(0, bound);
+      if (next_bound == kFound) {
+        result_.solved = true;
+        for (int move : path_) {
+          result_.path.push_back(moveToString<num_rows>(move));
+        }
+        return result_;
+      }
+      bound = next_bound;
+    }
+    if (bound != kUnsolvable) {
+      result_.lower_bound = bound;
+    }
+    return result_;
+  }
+
+private:
+  static constexpr int kFound = -1;
+
+  // Extends the path, which is |depth| moves long, as long as the heuristic
+  // says the goal could be reached within |bound| moves. Returns kFound if it
+  // was, and otherwise the smallest bound that would have let the search go
+  // further, or kUnsolvable if none would.
+  int search(int depth, int bound) {
+    const Board<num_rows, num_cols> board = boards_.back();
+    int estimate = heuristic_(board);
+    if (estimate == kUnsolvable) {
+      return kUnsolvable;
+    }
+    if (depth + estimate > bound) {
+      return depth + estimate;
+    }
+    if (board == win_) {
+      return kFound;
+    }
+
+    ++result_.states_expanded;
+    int next_bound = kUnsolvable;
+    int last_move = depth > 0 ? path_.back() : -1;
+    const LineFlags<num_rows, num_cols> lines = moves_.lineFlags(board);
+    for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+      if (pruning_.skip(last_move, move)) {
+        continue;
+      }
+      const Permutation<num_rows, num_cols> *permutation =
+          moves_.permutation(board, lines, move);
+      if (!permutation) {
+        continue;
+      }
+      Board<num_rows, num_cols> next = permutation->apply(board);
+      // Don't undo the last move, or make one that does nothing. Pruning
+      // catches most of these up front, but not ones that depend on the
+      // board.
+      if (next == board || (depth > 0 && next == boards_[depth - 1])) {
+        continue;
+      }
+      boards_.push_back(next);
+      path_.push_back(move);
+      int found = search(depth + 1, bound);
+      if (found == kFound) {
+        return kFound;
+      }
+      next_bound = std::min(next_bound, found);
+      boards_.pop_back();
+      path_.pop_back();
+    }
+    return next_bound;
+  }
+
+  const Board<num_rows, num_cols> &win_;
+  const MoveTable<num_rows, num_cols> &moves_;
+  const MovePruning<num_rows, num_cols> pruning_;
+  const Heuristic &heuristic_;
+  IdaStarResult result_;
+  // The boards along the current path, starting with the initial board.
+  std::vector<Board<num_rows, num_cols>> boards_;
+  // The moves along the current path, numbered as in move_table.h.
+  std::vector<uint8_t> path_;
+};
+
+// Finds a shortest path from |initial| to |win| of at most |max_depth| moves,
+// guided by |heuristic|.
+template <std::size_t num_rows, std::size_t num_cols, typename Heuristic>
+IdaStarResult solveIdaStar(const Board<num_rows, num_cols> &initial,
+                           const Board<num_rows, num_cols> &win,
+                           const MoveTable<num_rows, num_cols> &moves,
+                           const Heuristic &heuristic, int max_depth) {
+  return IdaStar<num_rows, num_cols, Heuristic>(win, moves, heuristic)
+      .solve(initial, max_depth);
+}
+
+// Same as above with CellDistanceHeuristic.
+template <std::size_t num_rows, std::size_t num_cols>
+IdaStarResult solveIdaStar(const Board<num_rows, num_cols> &initial,
+                           const Board<num_rows, num_cols> &win,
+                           const Rules &rules, int max_depth) {
+  MoveTable<num_rows, num_cols> moves(rules);
+  return solveIdaStar(initial, win, moves,
+                      CellDistanceHeuristic<num_rows, num_cols>(win, moves),
+                      max_depth);
+}
+
+#endif
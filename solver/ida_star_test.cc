@@ -0,0 +1,97 @@
+#include "ida_star.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mitm.h"
+
+// Applies a path in the app's notation to a board.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> applyPath(Board<num_rows, num_cols> board,
+                                    const std::vector<std::string> &path,
+                                    const Rules &rules) {
+  for (const std::string &move : path) {
+    bool forward = move.back() != '\'';
+    int offset = move[1] - '0';
+    if (move[0] == 'R') {
+      board = rowMove(board, offset, forward, rules.row_mode, rules.validation);
+    } else {
+      board = colMove(board, offset, forward, rules.col_mode, rules.validation);
+    }
+  }
+  return board;
+}
+
+TEST(IdaStar, AlreadySolved) {
+  const Board<2, 2> b = {{
+      {{1, 2}},
+      {{2, 1}},
+  }};
+
+  IdaStarResult result = solveIdaStar(b, b, Rules(), 10);
+  EXPECT_TRUE(result.solved);
+  EXPECT_TRUE(result.path.empty());
+}
+
+TEST(IdaStar, FindsOptimalPath) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 1 | FIXED}},
+  }};
+  const Board<3, 3> win = {{
+      {{1, 2, 3}},
+      {{1, 2, 3}},
+      {{1, 2, 1 | FIXED}},
+  }};
+  const Rules rules = {Mode::WIDE_1, Mode::WIDE_2, Validation::STATIC};
+
+  IdaStarResult result = solveIdaStar(initial, win, rules, 20);
+  ASSERT_TRUE(result.solved);
+  EXPECT_EQ(applyPath(initial, result.path, rules), win);
+  EXPECT_EQ(result.path.size(), 7);
+
+  IdaStarResult shallow = solveIdaStar(initial, win, rules, 5);
+  EXPECT_FALSE(shallow.solved);
+  EXPECT_GT(shallow.lower_bound, 5);
+  EXPECT_LE(shallow.lower_bound, 7);
+}
+
+TEST(IdaStar, Unsolvable) {
+  const Board<2, 2> initial = {{
+      {{1, 2 | FIXED}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> win = {{
+      {{2 | FIXED, 1}},
+      {{2, 1}},
+  }};
+  const Rules rules = {Mode::BASIC, Mode::BASIC, Validation::STATIC};
+
+  IdaStarResult result = solveIdaStar(initial, win, rules, 10);
+  EXPECT_FALSE(result.solved);
+  EXPECT_EQ(result.lower_bound, 0);
+}
+
+TEST(IdaStar, MatchesMitm) {
+  const Rules rules = {Mode::GEAR, Mode::CAROUSEL, Validation::NONE};
+  const Board<3, 4> win = {{
+      {{1, 1, 2, 2}},
+      {{3, 3, 4, 4}},
+      {{1, 2, 3, 4}},
+  }};
+  MoveTable<3, 4> moves(rules);
+  std::mt19937 rng(1);
+  for (int i = 0; i < 5; ++i) {
+    Board<3, 4> initial = win;
+    for (int j = 0; j < 8; ++j) {
+      initial = moves.permutation(initial, rng() % kNumMoves<3, 4>)
+                    ->apply(initial);
+    }
+    IdaStarResult result = solveIdaStar(initial, win, rules, 20);
+    ASSERT_TRUE(result.solved);
+    EXPECT_EQ(applyPath(initial, result.path, rules), win);
+    EXPECT_EQ(result.path.size(), solveMitm(initial, win, rules).path.size());
+  }
+}
@@ -0,0 +1,425 @@
+// Breadth first search that expands one layer (all the states at one depth) at
+// a time, optionally spreading each layer over several threads.
+//
+// Every state reached is kept in an arena along with the index of the state it
+// was reached from and the move used, so paths are only spelled out when
+// needed. The arena doubles as the queue.
+//
+// With more than one thread, a layer is expanded in batches. The threads
+// generate the neighbors of a batch of states and insert them into a shared
+// ConcurrentFlatHashMap at once. Each new key's value is first set to its
+// position among the batch's neighbors and lowered by any later duplicates
+// that come before it, so the one that's kept is the one a single thread would
+// have kept. So the states found, their order, and the paths to them are the
+// same whatever the number of threads.
+#ifndef LOOPINGDICE_LAYERED_SEARCH
+#define LOOPINGDICE_LAYERED_SEARCH
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "concurrent_hash.h"
+#include "packed_board.h"
+#include "snapshot.h"
+
+// Caps how many entries a search is presized for. Estimates of the state space
+// can be far bigger than the number of states a search actually reaches.
+constexpr size_t kMaxReserve = size_t{1} << 20;
+
+template <typename Key> struct SearchNode {
+  Key key;
+  // Index of the node this one was reached from. The root is its own parent.
+  uint32_t parent;
+  // The move, numbered as in move_table.h, that leads from the parent to this
+  // node, or from this node to the parent when searching backward.
+  uint8_t move;
+};
+
+// Calls f(thread) for each thread in [0, threads) at once and waits for them.
+template <typename F> void runOnThreads(int threads, const F &f) {
+  std::vector<std::thread> workers;
+  for (int thread = 1; thread < threads; ++thread) {
+    workers.emplace_back(f, thread);
+  }
+  f(0);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+// Where a search met another one: the index of the node in each.
+struct Meeting {
+  uint32_t index;
+  uint32_t other_index;
+};
+
+template <typename Key> class LayeredSearch {
+public:
+  // |expected| is a guess at how many states will be reached, used to size
+  // the visited set.
+  LayeredSearch(const Key &root, size_t expected, int threads = 1)
+      : threads_(std::max(1, threads)), seen_(std::min(expected, kMaxReserve)) {
+    nodes_.reserve(std::min(expected, kMaxReserve));
+    nodes_.push_back({root, 0, 0});
+    seen_.insert(root, 0);
+  }
+
+  const std::vector<SearchNode<Key>> &nodes() const { return nodes_; }
+  // Number of nodes that have been expanded. They're the first ones in
+  // nodes().
+  size_t expanded() const { return head_; }
+  bool done() const { return head_ == nodes_.size(); }
+  // Number of nodes the next call to expandLayer will expand.
+  size_t frontierSize() const { return nodes_.size() - head_; }
+
+  size_t memoryUsage() const {
+    return nodes_.capacity() * sizeof(SearchNode<Key>) + seen_.memoryUsage();
+  }
+
+  // memoryUsage() of a new search with room for |expected| states.
+  static size_t memoryUsageFor(size_t expected) {
+    expected = std::min(expected, kMaxReserve);
+    return expected * sizeof(SearchNode<Key>) +
+           ConcurrentFlatHashMap<Key, uint32_t, KeyHash>::memoryUsageFor(
+               expected);
+  }
+
+  // The most memory held while the search grows to |num_nodes| nodes,
+  // counting the old and new copies of the arena or visited set while either
+  // is moved to a bigger one.
+  size_t peakMemoryFor(size_t num_nodes) const {
+    size_t capacity = std::max<size_t>(1, nodes_.capacity());
+    while (capacity < num_nodes) {
+      capacity *= 2;
+    }
+    const size_t arena = capacity == nodes_.capacity()
+                             ? capacity
+                             : capacity + capacity / 2;
+    return arena * sizeof(SearchNode<Key>) + seen_.peakMemoryFor(num_nodes);
+  }
+
+  // The most nodes the search can grow to while peakMemoryFor() stays within
+  // |budget|, or nodes().size() if it can't grow at all.
+  size_t maxNodesWithin(size_t budget) const {
+    size_t low = nodes_.size();
+    size_t high = std::max(low, budget / sizeof(SearchNode<Key>)) + 1;
+    while (high - low > 1) {
+      const size_t mid = low + (high - low) / 2;
+      if (peakMemoryFor(mid) <= budget) {
+        low = mid;
+      } else {
+        high = mid;
+      }
+    }
+    return low;
+  }
+
+  uint64_t hash(const Key &key) const { return seen_.hash(key); }
+  void prefetch(uint64_t hash) const { seen_.prefetch(hash); }
+
+  // Returns the index of the node for |key|, whose hash is |hash|.
+  std::optional<uint32_t> find(const Key &key, uint64_t hash) const {
+    if (const std::atomic<uint32_t> *index = seen_.findWithHash(key, hash)) {
+      return index->load(std::memory_order_relaxed);
+    }
+    return std::nullopt;
+  }
+
+  // The moves from the root to node |index|, last move first.
+  std::vector<int> movesTo(uint32_t index) const {
+    std::vector<int> ret;
+    for (; nodes_[index].parent != index; index = nodes_[index].parent) {
+      ret.push_back(nodes_[index].move);
+    }
+    return ret;
+  }
+
+  // Writes the nodes and visited set so that load() can carry on from here.
+  // Call between layers.
+  void save(SnapshotWriter &writer) const {
+    writer.write(head_);
+    writer.write(nodes_.capacity());
+    writer.writeVector(nodes_);
+    seen_.save(writer);
+  }
+
+  // Replaces this search's state with one written by save().
+  bool load(SnapshotReader &reader) {
+    size_t capacity = 0;
+    if (!reader.read(head_) || !reader.read(capacity)) {
+      return false;
+    }
+    // The arena only ever has room for up to twice its nodes beyond what it
+    // was presized for, so a bigger capacity means a damaged snapshot.
+    const std::optional<uint64_t> bytes = reader.nextSize();
+    if (!bytes ||
+        capacity > std::max<uint64_t>(
+                       kMaxReserve, *bytes / sizeof(SearchNode<Key>) * 2)) {
+      return false;
+    }
+    // Keep the room the search had reserved so it grows the same way.
+    std::vector<SearchNode<Key>>().swap(nodes_);
+    nodes_.reserve(capacity);
+    return reader.readVector(nodes_) && head_ <= nodes_.size() &&
+           seen_.load(reader);
+  }
+
+  // Expands every node that was queued before this call. neighbors(key)
+  // returns a std::array of the keys reached by each move. It can also take
+  // the move that reached the node, or -1 for the root, as neighbors(key,
+  // last_move), to skip moves; see move_pruning.h. Skipped and disallowed
+  // moves give back |key|. If |invert_moves|, nodes record the inverse of the
+  // move that reached them, for searching backward from a goal, but
+  // neighbors still gets the move itself.
+  //
+  // If |other| is set, stops as soon as a new node is also in |other| and
+  // returns where they met. |other| isn't modified so it can be read by
+  // several threads.
+  //
+  // Stops before expanding any node whose neighbors could take the search
+  // past |max_nodes| nodes, leaving expanded() short of the end of the layer.
+  // See maxNodesWithin().
+  template <typename Neighbors>
+  std::optional<Meeting> expandLayer(const Neighbors &neighbors,
+                                     bool invert_moves,
+                                     const LayeredSearch *other = nullptr,
+                                     size_t max_nodes = SIZE_MAX) {
+    size_t layer_end = nodes_.size();
+    while (head_ < layer_end) {
+      constexpr size_t num_moves = std::tuple_size_v<Keys<Neighbors>>;
+      size_t batch_end = std::min(
+          layer_end, head_ + std::max<size_t>(1, kBatchSize / num_moves));
+      const size_t room =
+          max_nodes > nodes_.size() ? (max_nodes - nodes_.size()) / num_moves
+                                    : 0;
+      batch_end = std::min(batch_end, head_ + room);
+      if (batch_end == head_) {
+        return std::nullopt;
+      }
+      std::optional<Meeting> meeting =
+          threads_ == 1
+              ? expandSequentially(batch_end, neighbors, invert_moves, other)
+              : expandInParallel(batch_end, neighbors, invert_moves, other);
+      if (meeting) {
+        return meeting;
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  // Number of neighbors generated at once by expandInParallel. Room for all
+  // of them is reserved in the visited set, so this also bounds how far it
+  // can get ahead of the states actually found.
+  static constexpr size_t kBatchSize = 1 << 16;
+
+  template <typename Neighbors>
+  static constexpr bool kTakesLastMove =
+      std::is_invocable_v<const Neighbors &, const Key &, int>;
+
+  // What a Neighbors function returns.
+  template <typename Neighbors>
+  using Keys = typename std::conditional_t<
+      kTakesLastMove<Neighbors>,
+      std::invoke_result<const Neighbors &, const Key &, int>,
+      std::invoke_result<const Neighbors &, const Key &>>::type;
+
+  template <typename Neighbors>
+  Keys<Neighbors> neighborsOf(const Neighbors &neighbors, uint32_t index,
+                              bool invert_moves) const {
+    const SearchNode<Key> &node = nodes_[index];
+    if constexpr (kTakesLastMove<Neighbors>) {
+      return neighbors(node.key, node.parent == index
+                                     ? -1
+                                     : recordedMove(node.move, invert_moves));
+    } else {
+      return neighbors(node.key);
+    }
+  }
+
+  static uint8_t recordedMove(int move, bool invert_moves) {
+    return invert_moves ? move ^ 1 : move;
+  }
+
+  template <typename Neighbors>
+  std::optional<Meeting> expandSequentially(size_t batch_end,
+                                            const Neighbors &neighbors,
+                                            bool invert_moves,
+                                            const LayeredSearch *other) {
+    constexpr size_t num_moves = std::tuple_size_v<Keys<Neighbors>>;
+    std::array<uint64_t, num_moves> hashes;
+
+    while (head_ < batch_end) {
+      seen_.reserve(seen_.size() + num_moves);
+      uint32_t parent = head_++;
+      Keys<Neighbors> next = neighborsOf(neighbors, parent, invert_moves);
+      const Key key = nodes_[parent].key;
+      // Prefetch every slot before probing any so that the cache misses
+      // overlap.
+      for (size_t move = 0; move < num_moves; ++move) {
+        // Skipped and disallowed moves lead back to the node itself, which
+        // is already seen, so they don't need a lookup.
+        if (next[move] == key) {
+          continue;
+        }
+        hashes[move] = hash(next[move]);
+        prefetch(hashes[move]);
+        if (other) {
+          other->prefetch(hashes[move]);
+        }
+      }
+      for (size_t move = 0; move < num_moves; ++move) {
+        uint32_t index = nodes_.size();
+        if (next[move] == key ||
+            !seen_.insertWithHash(next[move], hashes[move], index).second) {
+          continue;
+        }
+        nodes_.push_back(
+            {next[move], parent, recordedMove(move, invert_moves)});
+        if (other) {
+          if (auto match = other->find(next[move], hashes[move])) {
+            return Meeting{index, *match};
+          }
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+  template <typename Neighbors>
+  std::optional<Meeting> expandInParallel(size_t batch_end,
+                                          const Neighbors &neighbors,
+                                          bool invert_moves,
+                                          const LayeredSearch *other) {
+    constexpr size_t num_moves = std::tuple_size_v<Keys<Neighbors>>;
+    const size_t batch_begin = head_;
+    const size_t num_parents = batch_end - batch_begin;
+    const size_t num_candidates = num_parents * num_moves;
+    const size_t num_chunks = std::min<size_t>(num_parents, 4 * threads_);
+    const size_t chunk_size = (num_parents + num_chunks - 1) / num_chunks;
+    // Values of keys first found in this batch start out as this plus the
+    // index of the candidate, which is more than any node's index so far.
+    const uint32_t first_candidate = nodes_.size();
+    seen_.reserve(seen_.size() + num_candidates);
+
+    // Candidate i is move i % num_moves of parent batch_begin + i / num_moves,
+    // which is the order a single thread would look at them in.
+    std::vector<Key> keys(num_candidates);
+    std::vector<uint64_t> hashes(num_candidates);
+    std::vector<std::atomic<uint32_t> *> values(num_candidates);
+    auto forEachChunk = [&](const auto &f) {
+      std::atomic<size_t> next_chunk = 0;
+      runOnThreads(threads_, [&](int) {
+        for (size_t chunk = next_chunk++; chunk < num_chunks;
+             chunk = next_chunk++) {
+          f(chunk, std::min(num_parents, chunk * chunk_size) * num_moves,
+            std::min(num_parents, (chunk + 1) * chunk_size) * num_moves);
+        }
+      });
+    };
+
+    forEachChunk([&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i += num_moves) {
+        const uint32_t parent = batch_begin + i / num_moves;
+        Keys<Neighbors> next = neighborsOf(neighbors, parent, invert_moves);
+        const Key key = nodes_[parent].key;
+        for (size_t move = 0; move < num_moves; ++move) {
+          keys[i + move] = next[move];
+          if (!(next[move] == key)) {
+            hashes[i + move] = hash(next[move]);
+            prefetch(hashes[i + move]);
+          }
+        }
+        for (size_t j = i; j < i + num_moves; ++j) {
+          if (keys[j] == key) {
+            values[j] = nullptr;
+            continue;
+          }
+          uint32_t value = first_candidate + j;
+          auto [stored, inserted] =
+              seen_.insertWithHash(keys[j], hashes[j], value);
+          values[j] = stored;
+          // Keep the first candidate with this key.
+          uint32_t current = stored->load(std::memory_order_relaxed);
+          while (!inserted && value < current &&
+                 !stored->compare_exchange_weak(current, value,
+                                                std::memory_order_relaxed)) {
+          }
+        }
+      }
+    });
+
+    // Append the new nodes in order.
+    std::vector<uint8_t> is_new(num_candidates);
+    std::vector<size_t> chunk_offsets(num_chunks + 1, nodes_.size());
+    forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+      size_t count = 0;
+      for (size_t i = begin; i < end; ++i) {
+        is_new[i] = values[i] && values[i]->load(std::memory_order_relaxed) ==
+                                     first_candidate + i;
+        count += is_new[i];
+      }
+      chunk_offsets[chunk + 1] = count;
+    });
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+    }
+    nodes_.resize(chunk_offsets[num_chunks]);
+    forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+      uint32_t index = chunk_offsets[chunk];
+      for (size_t i = begin; i < end; ++i) {
+        if (is_new[i]) {
+          nodes_[index] = {
+              keys[i], static_cast<uint32_t>(batch_begin + i / num_moves),
+              recordedMove(i % num_moves, invert_moves)};
+          values[i]->store(index++, std::memory_order_relaxed);
+        }
+      }
+    });
+
+    head_ = batch_end;
+    if (!other) {
+      return std::nullopt;
+    }
+
+    // Find the first new node that |other| has, which is where a single
+    // thread would have stopped.
+    std::vector<std::optional<Meeting>> meetings(num_chunks);
+    forEachChunk([&](size_t chunk, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if (is_new[i]) {
+          if (auto match = other->find(keys[i], hashes[i])) {
+            meetings[chunk] = Meeting{
+                values[i]->load(std::memory_order_relaxed), *match};
+            return;
+          }
+        }
+      }
+    });
+    for (const auto &meeting : meetings) {
+      if (meeting) {
+        nodes_.resize(meeting->index + 1);
+        head_ = nodes_[meeting->index].parent + 1;
+        return meeting;
+      }
+    }
+    return std::nullopt;
+  }
+
+  int threads_;
+  std::vector<SearchNode<Key>> nodes_;
+  // Maps keys to their index in |nodes_|.
+  ConcurrentFlatHashMap<Key, uint32_t, KeyHash> seen_;
+  // Nodes before this have been expanded.
+  size_t head_ = 0;
+};
+
+#endif
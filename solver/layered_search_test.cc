@@ -0,0 +1,178 @@
+#include "layered_search.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// A graph on the integers mod kSize whose layers get big enough to be split
+// into several batches.
+constexpr uint64_t kSize = 1000003;
+
+std::array<uint64_t, 4> neighbors(uint64_t key) {
+  return {(key * 3) % kSize, (key * 7 + 1) % kSize, (key + 1) % kSize,
+          (key + kSize - 1) % kSize};
+}
+
+std::vector<uint64_t> keys(const LayeredSearch<uint64_t> &search) {
+  std::vector<uint64_t> ret;
+  for (const auto &node : search.nodes()) {
+    ret.push_back(node.key);
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(LayeredSearch, VisitsEveryState) {
+  LayeredSearch<uint64_t> search(1, 0);
+  while (!search.done()) {
+    EXPECT_FALSE(search.expandLayer(neighbors, false));
+  }
+  EXPECT_EQ(search.nodes().size(), kSize);
+  EXPECT_EQ(search.expanded(), kSize);
+
+  // Following the moves from the root gets back to each node.
+  for (uint32_t index : {0u, 1u, 1000u, static_cast<uint32_t>(kSize - 1)}) {
+    uint64_t key = 1;
+    std::vector<int> moves = search.movesTo(index);
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+      key = neighbors(key)[*it];
+    }
+    EXPECT_EQ(key, search.nodes()[index].key);
+    EXPECT_EQ(search.find(key, search.hash(key)), index);
+  }
+}
+
+TEST(LayeredSearch, ThreadsDontChangeResult) {
+  LayeredSearch<uint64_t> sequential(1, 0, 1);
+  LayeredSearch<uint64_t> parallel(1, 0, 4);
+  while (!sequential.done()) {
+    sequential.expandLayer(neighbors, true);
+    parallel.expandLayer(neighbors, true);
+    ASSERT_EQ(keys(sequential), keys(parallel));
+    EXPECT_EQ(sequential.expanded(), parallel.expanded());
+  }
+  EXPECT_TRUE(parallel.done());
+  for (size_t i = 0; i < sequential.nodes().size(); ++i) {
+    ASSERT_EQ(sequential.nodes()[i].parent, parallel.nodes()[i].parent);
+    ASSERT_EQ(sequential.nodes()[i].move, parallel.nodes()[i].move);
+    uint64_t key = sequential.nodes()[i].key;
+    ASSERT_EQ(parallel.find(key, parallel.hash(key)), i);
+  }
+}
+
+TEST(LayeredSearch, MeetsOtherSearch) {
+  for (int threads : {1, 4}) {
+    LayeredSearch<uint64_t> fwd(1, 0, threads);
+    LayeredSearch<uint64_t> bwd(kSize / 2, 0, threads);
+    std::optional<Meeting> meeting;
+    while (!meeting && !fwd.done()) {
+      meeting = fwd.expandLayer(neighbors, false, &bwd);
+      if (!meeting) {
+        meeting = bwd.expandLayer(neighbors, false, &fwd);
+        if (meeting) {
+          std::swap(meeting->index, meeting->other_index);
+        }
+      }
+    }
+    ASSERT_TRUE(meeting);
+    EXPECT_EQ(fwd.nodes()[meeting->index].key,
+              bwd.nodes()[meeting->other_index].key);
+  }
+}
+
+TEST(LayeredSearch, MeetingIsSameForAnyThreads) {
+  auto meet = [](int threads) {
+    LayeredSearch<uint64_t> fwd(1, 0, threads);
+    LayeredSearch<uint64_t> bwd(kSize / 2, 0, threads);
+    // Fill in a few layers of |bwd| first so that |fwd| meets it partway
+    // through a big layer.
+    for (int i = 0; i < 8; ++i) {
+      bwd.expandLayer(neighbors, true);
+    }
+    std::optional<Meeting> meeting;
+    while (!meeting) {
+      meeting = fwd.expandLayer(neighbors, false, &bwd);
+    }
+    return std::make_tuple(meeting->index, meeting->other_index,
+                           fwd.expanded(), fwd.nodes().size());
+  };
+  EXPECT_EQ(meet(1), meet(4));
+}
+
+// Capped by maxNodesWithin(), a search stops partway through a layer rather
+// than grow past its budget, and can finish the layer later.
+TEST(LayeredSearch, StaysWithinBudget) {
+  LayeredSearch<uint64_t> search(1, 0);
+  const size_t budget = 1 << 20;
+  const size_t max_nodes = search.maxNodesWithin(budget);
+  EXPECT_LE(search.peakMemoryFor(max_nodes), budget);
+  EXPECT_GT(search.peakMemoryFor(max_nodes + 1), budget);
+
+  size_t layer_end;
+  do {
+    layer_end = search.nodes().size();
+    EXPECT_FALSE(search.expandLayer(neighbors, false, nullptr, max_nodes));
+  } while (search.expanded() == layer_end);
+  EXPECT_LE(search.nodes().size(), max_nodes);
+  EXPECT_LE(search.memoryUsage(), budget);
+
+  search.expandLayer(neighbors, false);
+  EXPECT_EQ(search.expanded(), search.nodes().size() - search.frontierSize());
+  EXPECT_GE(search.expanded(), layer_end);
+}
+
+// A search saved partway and loaded into another one carries on as if it had
+// never stopped.
+TEST(LayeredSearch, ResumesFromSnapshot) {
+  const std::string path = testing::TempDir() + "/layered_search";
+  LayeredSearch<uint64_t> uninterrupted(1, 0);
+  while (!uninterrupted.done()) {
+    uninterrupted.expandLayer(neighbors, false);
+  }
+
+  LayeredSearch<uint64_t> first(1, 0);
+  for (int i = 0; i < 6; ++i) {
+    first.expandLayer(neighbors, false);
+  }
+  {
+    SnapshotWriter writer(path, "search");
+    first.save(writer);
+    ASSERT_TRUE(writer.commit());
+  }
+  LayeredSearch<uint64_t> resumed(1, 0, 4);
+  SnapshotReader reader(path, "search");
+  ASSERT_TRUE(resumed.load(reader));
+  EXPECT_EQ(resumed.expanded(), first.expanded());
+  while (!resumed.done()) {
+    resumed.expandLayer(neighbors, false);
+  }
+  EXPECT_EQ(keys(resumed), keys(uninterrupted));
+  EXPECT_EQ(resumed.movesTo(kSize - 1), uninterrupted.movesTo(kSize - 1));
+}
+
+// A damaged arena capacity fails to load rather than being reserved.
+TEST(LayeredSearch, LoadDamagedCapacity) {
+  const std::string path = testing::TempDir() + "/damaged_layered_search";
+  LayeredSearch<uint64_t> search(1, 0);
+  search.expandLayer(neighbors, false);
+  {
+    SnapshotWriter writer(path, "search");
+    writer.write(search.expanded());
+    writer.write(size_t{1} << 60);
+    writer.writeVector(search.nodes());
+    ASSERT_TRUE(writer.commit());
+  }
+  LayeredSearch<uint64_t> loaded(1, 0);
+  SnapshotReader reader(path, "search");
+  ASSERT_TRUE(reader.ok());
+  EXPECT_FALSE(loaded.load(reader));
+}
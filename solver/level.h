@@ -0,0 +1,239 @@
+// Helpers for reading levels in the format the app uses, see
+// app/src/main/assets/levels and the "Data format for levels" section of the
+// top level README.
+#ifndef LOOPINGDICE_LEVEL
+#define LOOPINGDICE_LEVEL
+
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "enums.h"
+#include "puzzle.h"
+
+// A level along with the extra information stored next to it.
+struct Level {
+  Puzzle puzzle;
+  std::string help_text;
+  // Solutions listed on lines that begin with "#", in the notation mitm.cc
+  // prints, e.g. {"R0", "C2'"}.
+  std::vector<std::vector<std::string>> solutions;
+};
+
+// The app only has colours 0 to 35.
+constexpr int kMaxColor = 35;
+
+// Inverse of cellToString. Numbers outside the app's colours are rejected.
+inline std::optional<int> parseCell(absl::string_view str) {
+  int cell = 0;
+  for (absl::string_view part : absl::StrSplit(str, ' ', absl::SkipEmpty())) {
+    int number;
+    if (part == "U") {
+      cell |= UP;
+    } else if (part == "D") {
+      cell |= DOWN;
+    } else if (part == "L") {
+      cell |= LEFT;
+    } else if (part == "R") {
+      cell |= RIGHT;
+    } else if (part == "E") {
+      cell |= ENABLER;
+    } else if (part == "F") {
+      cell |= FIXED;
+    } else if (part == "B") {
+      cell |= LIGHTNING;
+    } else if (part == "H") {
+      cell |= HORIZ;
+    } else if (part == "V") {
+      cell |= VERT;
+    } else if (absl::SimpleAtoi(part, &number) && number >= 0 &&
+               number <= kMaxColor) {
+      cell |= number;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return cell;
+}
+
+// Parses the first |num_cells| cells of a comma separated list. Like the app,
+// anything after that is ignored.
+inline std::optional<std::vector<int>> parseCells(absl::string_view str,
+                                                  size_t num_cells) {
+  std::vector<int> cells;
+  for (absl::string_view part : absl::StrSplit(str, ',')) {
+    if (cells.size() == num_cells) {
+      break;
+    }
+    std::optional<int> cell = parseCell(part);
+    if (!cell) {
+      return std::nullopt;
+    }
+    cells.push_back(*cell);
+  }
+  if (cells.size() != num_cells) {
+    return std::nullopt;
+  }
+  return cells;
+}
+
+// Inverse of modesToString.
+inline std::optional<Rules> parseModes(absl::string_view str) {
+  std::vector<absl::string_view> parts = absl::StrSplit(str, '|');
+  if (parts.size() != 3) {
+    return std::nullopt;
+  }
+  std::optional<Mode> row_mode = parseMode(parts[0]);
+  std::optional<Mode> col_mode = parseMode(parts[1]);
+  std::optional<Validation> validation = parseValidation(parts[2]);
+  if (!row_mode || !col_mode || !validation) {
+    return std::nullopt;
+  }
+  return Rules{*row_mode, *col_mode, *validation};
+}
+
+// Parses a solution line like "# R0,C2',R1 (3)". Also accepts the older
+// "# Row0 Col2' Row1 (3)" notation.
+inline std::optional<std::vector<std::string>> parseSolution(
+    absl::string_view str) {
+  if (!absl::ConsumePrefix(&str, "#")) {
+    return std::nullopt;
+  }
+  str = absl::StripAsciiWhitespace(str);
+  size_t paren = str.rfind('(');
+  if (paren != absl::string_view::npos) {
+    str = absl::StripAsciiWhitespace(str.substr(0, paren));
+  }
+
+  std::vector<std::string> moves;
+  for (absl::string_view part :
+       absl::StrSplit(str, absl::ByAnyChar(", "), absl::SkipEmpty())) {
+    std::string move;
+    if (absl::ConsumePrefix(&part, "Row") || absl::ConsumePrefix(&part, "R")) {
+      move = "R";
+    } else if (absl::ConsumePrefix(&part, "Col") ||
+               absl::ConsumePrefix(&part, "C")) {
+      move = "C";
+    } else {
+      return std::nullopt;
+    }
+    bool backward = absl::ConsumeSuffix(&part, "'");
+    int offset;
+    if (!absl::SimpleAtoi(part, &offset)) {
+      return std::nullopt;
+    }
+    move += std::to_string(offset) + (backward ? "'" : "");
+    moves.push_back(move);
+  }
+  return moves;
+}
+
+// Parses the contents of a level file.
+inline std::optional<Level> parseLevel(absl::string_view contents) {
+  std::vector<absl::string_view> lines = absl::StrSplit(contents, '\n');
+  for (absl::string_view &line : lines) {
+    absl::ConsumeSuffix(&line, "\r");
+  }
+  if (lines.size() < 5) {
+    return std::nullopt;
+  }
+
+  Level level;
+  int num_rows;
+  int num_cols;
+  if (!absl::SimpleAtoi(lines[0], &num_rows) ||
+      !absl::SimpleAtoi(lines[1], &num_cols) || num_rows <= 0 ||
+      num_cols <= 0) {
+    return std::nullopt;
+  }
+  level.puzzle.num_rows = num_rows;
+  level.puzzle.num_cols = num_cols;
+
+  std::optional<Rules> rules = parseModes(lines[2]);
+  if (!rules) {
+    return std::nullopt;
+  }
+  level.puzzle.rules = *rules;
+
+  std::optional<std::vector<int>> initial =
+      parseCells(lines[3], num_rows * num_cols);
+  std::optional<std::vector<int>> win =
+      parseCells(lines[4], num_rows * num_cols);
+  if (!initial || !win) {
+    return std::nullopt;
+  }
+  level.puzzle.initial = *initial;
+  level.puzzle.win = *win;
+
+  if (lines.size() > 5) {
+    level.help_text = std::string(lines[5]);
+  }
+  for (size_t i = 6; i < lines.size(); ++i) {
+    if (absl::StartsWith(lines[i], "#")) {
+      std::optional<std::vector<std::string>> solution =
+          parseSolution(lines[i]);
+      if (solution) {
+        level.solutions.push_back(*solution);
+      }
+    }
+  }
+
+  return level;
+}
+
+inline std::optional<std::string> readFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    return std::nullopt;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Reads and parses a level file.
+inline std::optional<Level> loadLevel(const std::string &path) {
+  std::optional<std::string> contents = readFile(path);
+  if (!contents) {
+    return std::nullopt;
+  }
+  return parseLevel(*contents);
+}
+
+// A list of levels as stored in app/src/main/assets/packs. The first line is
+// the title and each following line is "<display id> <canonical id> <pars>".
+struct Pack {
+  std::string title;
+  // Canonical IDs, which are also the level's filename without ".txt".
+  std::vector<std::string> level_ids;
+};
+
+inline std::optional<Pack> parsePack(absl::string_view contents) {
+  std::vector<absl::string_view> lines =
+      absl::StrSplit(contents, '\n', absl::SkipWhitespace());
+  if (lines.empty()) {
+    return std::nullopt;
+  }
+
+  Pack pack;
+  pack.title = std::string(absl::StripAsciiWhitespace(lines[0]));
+  for (size_t i = 1; i < lines.size(); ++i) {
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(lines[i], ' ', absl::SkipEmpty());
+    if (parts.size() < 2) {
+      return std::nullopt;
+    }
+    pack.level_ids.push_back(std::string(parts[1]));
+  }
+  return pack;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "level.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+TEST(Level, ParseCell) {
+  EXPECT_EQ(parseCell("3"), 3);
+  EXPECT_EQ(parseCell("F 1"), FIXED | 1);
+  EXPECT_EQ(parseCell("U D R 3"), UP | DOWN | RIGHT | 3);
+  EXPECT_EQ(parseCell("E"), ENABLER);
+  EXPECT_EQ(parseCell("V E"), VERT | ENABLER);
+  EXPECT_EQ(parseCell("NaN"), std::nullopt);
+  EXPECT_EQ(parseCell("X 1"), std::nullopt);
+  EXPECT_EQ(parseCell("35"), 35);
+  EXPECT_EQ(parseCell("-5"), std::nullopt);
+  EXPECT_EQ(parseCell("36"), std::nullopt);
+  EXPECT_EQ(parseCell("F 100000"), std::nullopt);
+}
+
+TEST(Level, ParseCellIsInverseOfCellToString) {
+  for (int flags : {0, HORIZ, VERT, UP | LEFT, DOWN | RIGHT, LIGHTNING,
+                    FIXED | LIGHTNING, ENABLER | UP | DOWN | LEFT | RIGHT}) {
+    for (int color : {0, 1, 5, 27}) {
+      EXPECT_EQ(parseCell(cellToString(flags | color)), flags | color);
+    }
+  }
+}
+
+TEST(Level, ParseModes) {
+  std::optional<Rules> rules = parseModes("WIDE 1|GEAR|ARROWS+ENABLER");
+  ASSERT_TRUE(rules.has_value());
+  EXPECT_EQ(rules->row_mode, Mode::WIDE_1);
+  EXPECT_EQ(rules->col_mode, Mode::GEAR);
+  EXPECT_EQ(rules->validation, Validation::ARROWS | Validation::ENABLER);
+
+  rules = parseModes(
+      modesToString(Mode::LIGHTNING, Mode::LIGHTNING, Validation::DYNAMIC));
+  ASSERT_TRUE(rules.has_value());
+  EXPECT_EQ(rules->row_mode, Mode::LIGHTNING);
+  EXPECT_EQ(rules->col_mode, Mode::LIGHTNING);
+  EXPECT_EQ(rules->validation, Validation::DYNAMIC);
+
+  EXPECT_EQ(parseModes("BASIC|BASIC"), std::nullopt);
+  EXPECT_EQ(parseModes("BASIC|SPIRAL|NONE"), std::nullopt);
+}
+
+TEST(Level, ParseSolution) {
+  EXPECT_THAT(parseSolution("# R2',C1,R0 (3)"),
+              testing::Optional(
+                  std::vector<std::string>({"R2'", "C1", "R0"})));
+  EXPECT_THAT(parseSolution("# Col0' Row5 Row3' (3)"),
+              testing::Optional(
+                  std::vector<std::string>({"C0'", "R5", "R3'"})));
+  EXPECT_EQ(parseSolution("R0,C1' (2)"), std::nullopt);
+  EXPECT_EQ(parseSolution("# Up (1)"), std::nullopt);
+}
+
+TEST(Level, ParseLevel) {
+  std::optional<Level> level = parseLevel("4\n"
+                                          "3\n"
+                                          "WIDE 1|WIDE 1|ARROWS\n"
+                                          "3,H 0,1,V 0,1,1,1,1,V 0,1,H 0,3\n"
+                                          "1,H 0,3,1,1,V 0,V 0,1,1,3,H 0,1\n"
+                                          "\n"
+                                          "# C0,R1',C2',C0',R2,C0 (6)\n"
+                                          "human solution: Col2' Row2 (2)");
+  ASSERT_TRUE(level.has_value());
+  EXPECT_EQ(level->puzzle.num_rows, 4);
+  EXPECT_EQ(level->puzzle.num_cols, 3);
+  EXPECT_EQ(level->puzzle.rules.row_mode, Mode::WIDE_1);
+  EXPECT_EQ(level->puzzle.rules.col_mode, Mode::WIDE_1);
+  EXPECT_EQ(level->puzzle.rules.validation, Validation::ARROWS);
+  EXPECT_EQ(level->puzzle.initial,
+            std::vector<int>({3, HORIZ, 1, VERT, 1, 1, 1, 1, VERT, 1, HORIZ,
+                              3}));
+  EXPECT_EQ(level->puzzle.win,
+            std::vector<int>({1, HORIZ, 3, 1, 1, VERT, VERT, 1, 1, 3, HORIZ,
+                              1}));
+  EXPECT_EQ(level->help_text, "");
+  EXPECT_THAT(level->solutions,
+              testing::ElementsAre(std::vector<std::string>(
+                  {"C0", "R1'", "C2'", "C0'", "R2", "C0"})));
+}
+
+TEST(Level, ParseLevelIgnoresExtraCells) {
+  std::optional<Level> level = parseLevel("1\n"
+                                          "2\n"
+                                          "GEAR|GEAR|NONE\n"
+                                          "1,2,NaN\n"
+                                          "2,1\n"
+                                          "Some help text\n");
+  ASSERT_TRUE(level.has_value());
+  EXPECT_EQ(level->puzzle.initial, std::vector<int>({1, 2}));
+  EXPECT_EQ(level->help_text, "Some help text");
+  EXPECT_TRUE(level->solutions.empty());
+}
+
+TEST(Level, ParseLevelErrors) {
+  // Too few lines
+  EXPECT_EQ(parseLevel("2\n2\nBASIC|BASIC|NONE\n1,1,2,2\n"), std::nullopt);
+  // Bad size
+  EXPECT_EQ(parseLevel("two\n2\nBASIC|BASIC|NONE\n1,1,2,2\n1,2,1,2\n"),
+            std::nullopt);
+  // Bad modes
+  EXPECT_EQ(parseLevel("2\n2\nBASIC|NONE\n1,1,2,2\n1,2,1,2\n"), std::nullopt);
+  // Too few cells
+  EXPECT_EQ(parseLevel("2\n2\nBASIC|BASIC|NONE\n1,1,2\n1,2,1,2\n"),
+            std::nullopt);
+}
+
+TEST(Level, ParsePack) {
+  std::optional<Pack> pack = parsePack("Arrows (Beginner)\n"
+                                       "A1 a_intro 4 5 6\n"
+                                       "A2 a_belt 5 6 8\n"
+                                       "\n");
+  ASSERT_TRUE(pack.has_value());
+  EXPECT_EQ(pack->title, "Arrows (Beginner)");
+  EXPECT_THAT(pack->level_ids, testing::ElementsAre("a_intro", "a_belt"));
+
+  EXPECT_EQ(parsePack(""), std::nullopt);
+  EXPECT_EQ(parsePack("Title\nA1\n"), std::nullopt);
+}
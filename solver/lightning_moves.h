@@ -7,10 +7,11 @@
 
 template <std::size_t num_rows, std::size_t num_cols>
 bool validateLightningRowMove(const Board<num_rows, num_cols> &board,
+                              const LineFlags<num_rows, num_cols> &lines,
                               int offset, bool forward,
                               const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (row_contains_fixed_cell(board, offset)) {
+    if (row_contains_fixed_cell(lines, offset)) {
       return false;
     }
   }
@@ -18,18 +19,18 @@ bool validateLightningRowMove(const Board<num_rows, num_cols> &board,
     size_t end = forward ? num_cols - 1 : 0;
     size_t pre_end = forward ? num_cols - 2 : 1;
     if ((board[offset][end] & FIXED) ||
-        (num_cols > 1 && row_contains_lightning(board, offset) &&
+        (num_cols > 1 && row_contains_lightning(lines, offset) &&
          board[offset][pre_end] & FIXED)) {
       return false;
     }
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
-    if (row_contains_arrows_cell(board, offset)) {
+    if (row_contains_arrows_cell(lines, offset)) {
       return false;
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!row_contains_enabler(board, offset)) {
+    if (!row_contains_enabler(lines, offset)) {
       return false;
     }
   }
@@ -37,6 +38,14 @@ bool validateLightningRowMove(const Board<num_rows, num_cols> &board,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateLightningRowMove(const Board<num_rows, num_cols> &board,
+                              int offset, bool forward,
+                              const Validation &validation) {
+  return validateLightningRowMove(board, LineFlags<num_rows, num_cols>(board),
+                                  offset, forward, validation);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> lightningRowMove(Board<num_rows, num_cols> board,
                                            int offset, bool forward,
@@ -54,10 +63,11 @@ Board<num_rows, num_cols> lightningRowMove(Board<num_rows, num_cols> board,
 
 template <std::size_t num_rows, std::size_t num_cols>
 bool validateLightningColMove(const Board<num_rows, num_cols> &board,
+                              const LineFlags<num_rows, num_cols> &lines,
                               int offset, bool forward,
                               const Validation &validation) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
-    if (col_contains_fixed_cell(board, offset)) {
+    if (col_contains_fixed_cell(lines, offset)) {
       return false;
     }
   }
@@ -65,18 +75,18 @@ bool validateLightningColMove(const Board<num_rows, num_cols> &board,
     size_t end = forward ? num_rows - 1 : 0;
     size_t pre_end = forward ? num_rows - 2 : 1;
     if ((board[end][offset] & FIXED) ||
-        (num_cols > 1 && col_contains_lightning(board, offset) &&
+        (num_rows > 1 && col_contains_lightning(lines, offset) &&
          board[pre_end][offset] & FIXED)) {
       return false;
     }
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
-    if (col_contains_arrows_cell(board, offset)) {
+    if (col_contains_arrows_cell(lines, offset)) {
       return false;
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
-    if (!col_contains_enabler(board, offset)) {
+    if (!col_contains_enabler(lines, offset)) {
       return false;
     }
   }
@@ -84,6 +94,14 @@ bool validateLightningColMove(const Board<num_rows, num_cols> &board,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateLightningColMove(const Board<num_rows, num_cols> &board,
+                              int offset, bool forward,
+                              const Validation &validation) {
+  return validateLightningColMove(board, LineFlags<num_rows, num_cols>(board),
+                                  offset, forward, validation);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> lightningColMove(Board<num_rows, num_cols> board,
                                            int offset, bool forward,
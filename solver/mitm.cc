@@ -1,191 +1,79 @@
+#include <cstdint>
 #include <iostream>
-#include <memory>
-#include <unordered_map>
+#include <optional>
+#include <string>
 
-#include <queue>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_join.h"
 #include "board.h"
+#include "dispatch.h"
 #include "enums.h"
-#include "moves.h"
-
-// Global settings
-constexpr size_t num_rows = 4;
-constexpr size_t num_cols = 4;
-
-constexpr Board<num_rows, num_cols> initial = {{
-  {{FIXED|1,ENABLER,ENABLER,FIXED|1}},
-  {{1,FIXED|1,FIXED|1,2}},
-  {{1,FIXED|1,FIXED|1,2}},
-  {{FIXED|1,3,3,FIXED|1}},
-}};
-constexpr Board<num_rows, num_cols> win = {{
-  {{FIXED|1,2,2,FIXED|1}},
-  {{ENABLER,FIXED|1,FIXED|1,3}},
-  {{ENABLER,FIXED|1,FIXED|1,3}},
-  {{FIXED|1,1,1,FIXED|1}},
-}};
-constexpr Mode row_mode = Mode::BASIC;
-constexpr Mode col_mode = Mode::BASIC;
-const Validation validation = Validation::ENABLER | Validation::DYNAMIC;
-
-template<std::size_t num_rows, std::size_t num_cols>
-struct Node {
-  Board<num_rows, num_cols> board;
-  std::vector<std::string> path;
-  Node(const Board<num_rows, num_cols>& b, const std::vector<std::string>& p) 
-    : board(b), path(p) {}
-};
-
-std::vector<std::string> make_path(std::vector<std::string> path,
-    const std::string& move) {
-  path.push_back(move);
-  return path;
-}
-
-// helpers for doing bfs
-template<std::size_t num_rows, std::size_t num_cols>
-std::vector<Node<num_rows, num_cols>> exploreNeighbors(
-    const Board<num_rows, num_cols>& board,
-    const std::vector<std::string>& path) {
-  std::vector<Node<num_rows, num_cols>> ret;
-
-  for (size_t row = 0; row < num_rows; ++row) {
-    Board<num_rows, num_cols> forward = rowMove(board, row, true, row_mode, validation);
-    ret.push_back(Node<num_rows, num_cols>(
-          forward, make_path(path,"R" + std::to_string(row))));
-
-    Board<num_rows, num_cols> backward = rowMove(board, row, false, row_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(backward, make_path(path, "R" + std::to_string(row) + "'")));
-  }
-
-  for (size_t col = 0; col < num_cols; ++col) {
-    Board<num_rows, num_cols> forward = colMove(board, col, true, col_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(forward, make_path(path, "C" + std::to_string(col))));
-
-    Board<num_rows, num_cols> backward = colMove(board, col, false, col_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(backward, make_path(path, "C" + std::to_string(col) + "'")));
-  }
-
-  return ret;
-}
-
-template<std::size_t num_rows, std::size_t num_cols>
-std::vector<Node<num_rows, num_cols>> exploreNeighborsBackward(
-    const Board<num_rows, num_cols>& board,
-    const std::vector<std::string>& path) {
-  std::vector<Node<num_rows, num_cols>> ret;
-
-  for (size_t row = 0; row < num_rows; ++row) {
-    Board<num_rows, num_cols> forward = rowMove(board, row, true, row_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(forward, make_path(path, "R" + std::to_string(row) + "'")));
-
-    Board<num_rows, num_cols> backward = rowMove(board, row, false, row_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(backward, make_path(path,"R" + std::to_string(row))));
-  }
-
-  for (size_t col = 0; col < num_cols; ++col) {
-    Board<num_rows, num_cols> forward = colMove(board, col, true, col_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(forward, make_path(path, "C" + std::to_string(col) + "'")));
-
-    Board<num_rows, num_cols> backward = colMove(board, col, false, col_mode, validation);
-    ret.push_back(
-        Node<num_rows, num_cols>(backward, make_path(path, "C" + std::to_string(col))));
-  }
-
-  return ret;
-}
-
-void printSolution(const std::vector<std::string>& fwd,
-    const std::vector<std::string>& bwd) {
+#include "mitm.h"
+#include "puzzle.h"
+#include "puzzle_flags.h"
+#include "snapshot.h"
+
+ABSL_FLAG(int, threads, 1, "Number of threads to expand each layer with");
+ABSL_FLAG(bool, symmetry, true,
+          "Search boards that are symmetric with respect to the goal only "
+          "once");
+ABSL_FLAG(std::string, checkpoint, "",
+          "If set, save the search to this file every --checkpoint_seconds "
+          "and, if the file already holds a save of the same search, pick up "
+          "from it.");
+ABSL_FLAG(double, checkpoint_seconds, 600,
+          "How often to save the search to --checkpoint.");
+ABSL_FLAG(int64_t, max_memory_mb, 0,
+          "Once the search's tables would grow past this, stop growing them "
+          "and go on by depth first search, which is slower. 0 for no limit.");
+ABSL_FLAG(int, max_depth, 100,
+          "After --max_memory_mb is reached, give up on solutions longer than "
+          "this and print how long any solution must be instead.");
+
+void printSolution(const std::vector<std::string>& path) {
   std::cout << "# "
-    << absl::StrJoin(fwd, ",")
-    << "," 
-    << absl::StrJoin(bwd.rbegin(), bwd.rend(), ",")
-    << " (" << fwd.size() + bwd.size() << ")"
+    << absl::StrJoin(path, ",")
+    << " (" << path.size() << ")"
     << std::endl;
 }
 
-
-int main () {
-  if (!isCompatible(row_mode, col_mode)) {
-    std::cout << "Row mode and col mode are not compatible" << std::endl;
-    return 1;
-  }
-  if (!moveFits(row_mode, num_rows)) {
-    std::cout << "Row move affects too many rows" << std::endl;
-    return 2;
+int main (int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<Puzzle> puzzle = puzzleFromFlags();
+  if (!puzzle) {
+    return 7;
   }
-  if (!moveFits(col_mode, num_cols)) {
-    std::cout << "col move affects too many rows" << std::endl;
-    return 3;
+  if (int error = checkPuzzle(*puzzle)) {
+    return error;
   }
-  if (!sameElements(initial, win)) {
-    std::cout << "Initial and win must contain the same elements" << std::endl;
-    return 4;
-  }
-
-  std::cout << num_rows << std::endl
-    << num_cols << std::endl
-    << modesToString(row_mode, col_mode, validation) << std::endl
-    << boardToString(initial, row_mode, ",") << std::endl
-    << boardToString(win, row_mode, ",") << std::endl;
-
-  std::queue<Node<num_rows, num_cols>> fwd_q;
-  fwd_q.push(Node<num_rows, num_cols>(initial, {}));
-  std::unordered_map<Board<num_rows, num_cols>, std::vector<std::string>> fwd_seen;
-  fwd_seen[initial] = {};
-
-  std::queue<Node<num_rows, num_cols>> bwd_q;
-  bwd_q.push(Node<num_rows, num_cols>(win, {}));
-  std::unordered_map<Board<num_rows, num_cols>, std::vector<std::string>> bwd_seen;
-  bwd_seen[win] = {};
 
-  unsigned int target_depth = 1;
-  
-  while (!fwd_q.empty() || !bwd_q.empty()) {
-    // Explore forward.
-    while (!fwd_q.empty() && fwd_q.front().path.size() < target_depth) {
-      Node<num_rows, num_cols> next = fwd_q.front();
-      auto neighbors = exploreNeighbors(next.board, next.path);
-      for (const auto& neighbor : neighbors) {
-        // New cell, note we've seen it and add it to the queue to explore more
-        if (fwd_seen.find(neighbor.board) == fwd_seen.end()) {
-          fwd_seen[neighbor.board] = neighbor.path;
-          fwd_q.push(Node<num_rows, num_cols>(neighbor.board, neighbor.path));
-          if (bwd_seen.find(neighbor.board) != bwd_seen.end()) {
-            printSolution(neighbor.path, bwd_seen[neighbor.board]);
-            return 0;
-          }
-        }
-      }
-      fwd_q.pop();
+  return dispatchBySize(*puzzle, [&](const auto& initial, const auto& win) {
+    std::cout << puzzle->num_rows << std::endl
+      << puzzle->num_cols << std::endl
+      << modesToString(puzzle->rules.row_mode, puzzle->rules.col_mode,
+                       puzzle->rules.validation) << std::endl
+      << boardToString(initial, puzzle->rules.row_mode, ",") << std::endl
+      << boardToString(win, puzzle->rules.row_mode, ",") << std::endl;
+
+    MitmResult result = solveMitm(
+        initial, win, puzzle->rules, absl::GetFlag(FLAGS_threads),
+        absl::GetFlag(FLAGS_symmetry),
+        CheckpointOptions{absl::GetFlag(FLAGS_checkpoint),
+                          absl::GetFlag(FLAGS_checkpoint_seconds)},
+        MitmBudget{size_t(absl::GetFlag(FLAGS_max_memory_mb)) << 20,
+                   absl::GetFlag(FLAGS_max_depth)});
+    if (!result.error.empty()) {
+      std::cout << result.error << std::endl;
+      return 10;
     }
-
-    // Explore backward.
-    while (!bwd_q.empty() && bwd_q.front().path.size() < target_depth) {
-      Node<num_rows, num_cols> next = bwd_q.front();
-      auto neighbors = exploreNeighborsBackward(next.board, next.path);
-      for (const auto& neighbor : neighbors) {
-        if (bwd_seen.find(neighbor.board) == bwd_seen.end()) {
-          // New cell, note we've seen it and add it to the queue to explore more
-          bwd_seen[neighbor.board] = neighbor.path;
-          bwd_q.push(Node<num_rows, num_cols>(neighbor.board, neighbor.path));
-          if (fwd_seen.find(neighbor.board) != fwd_seen.end()) {
-            printSolution(fwd_seen[neighbor.board], neighbor.path);
-            return 0;
-          }
-        }
-      }
-      bwd_q.pop();
+    if (result.solved) {
+      printSolution(result.path);
+    } else if (result.lower_bound) {
+      std::cout << "# Gave up past --max_depth; no solution is shorter than "
+                << result.lower_bound << " moves" << std::endl;
+      return 11;
     }
-
-    ++target_depth;
-  }
-
-  return 0;
+    return 0;
+  });
 }
@@ -0,0 +1,443 @@
+// Meet-in-the-middle breadth first search for an optimal path between two
+// boards.
+#ifndef LOOPINGDICE_MITM
+#define LOOPINGDICE_MITM
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+#include "layered_search.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "packed_board.h"
+#include "puzzle.h"
+#include "snapshot.h"
+#include "symmetry.h"
+
+// The outcome of a search. |path| is in the notation the app accepts, e.g.
+// {"R0", "C2'"}.
+struct MitmResult {
+  bool solved = false;
+  std::vector<std::string> path;
+  // Number of boards whose neighbors were generated.
+  size_t states_expanded = 0;
+  // Approximate peak number of bytes held by the arenas and seen maps.
+  size_t peak_bytes = 0;
+  // Set if a checkpoint couldn't be loaded or saved, which stops the search.
+  std::string error;
+  // If the search gave up within its MitmBudget, the length no path can be
+  // shorter than. Otherwise 0, so an unsolved result with a 0 lower bound
+  // means there's no path at all.
+  int lower_bound = 0;
+};
+
+// Limits on a search. When the two sides' arenas and visited sets would
+// outgrow |max_memory| bytes, both are frozen and the side that was being
+// expanded carries on by depth first search from its last layer, checking
+// each board it reaches against the other side. That needs no more memory,
+// but it's slower and goes on until it finds a path or the paths it would
+// find are longer than |max_depth| moves.
+struct MitmBudget {
+  // 0 for no limit.
+  size_t max_memory = 0;
+  int max_depth = 100;
+};
+
+// Spells out the path through the node with index |fwd_index| on the forward
+// side and |bwd_index| on the backward side.
+template<std::size_t num_rows, typename Key>
+std::vector<std::string> joinPaths(const LayeredSearch<Key>& fwd,
+    uint32_t fwd_index, const LayeredSearch<Key>& bwd, uint32_t bwd_index) {
+  std::vector<int> fwd_moves = fwd.movesTo(fwd_index);
+  std::vector<int> bwd_moves = bwd.movesTo(bwd_index);
+  std::vector<std::string> ret;
+  for (auto it = fwd_moves.rbegin(); it != fwd_moves.rend(); ++it) {
+    ret.push_back(moveToString<num_rows>(*it));
+  }
+  for (int move : bwd_moves) {
+    ret.push_back(moveToString<num_rows>(move));
+  }
+  return ret;
+}
+
+// The keys of the nodes from |search|'s root to node |index|.
+template<typename Key>
+std::vector<Key> keysTo(const LayeredSearch<Key>& search, uint32_t index) {
+  std::vector<Key> ret;
+  for (;; index = search.nodes()[index].parent) {
+    ret.push_back(search.nodes()[index].key);
+    if (search.nodes()[index].parent == index) {
+      break;
+    }
+  }
+  std::reverse(ret.begin(), ret.end());
+  return ret;
+}
+
+// Finds moves that lead from |initial| through the boards with each of |keys|
+// after the first in turn. With |canonicalize| the keys are of canonical
+// boards, which stand for every board symmetric to them, and at each step
+// this finds a move on the actual board that leads into the next set. One
+// always exists since symmetries map moves to moves, so nullopt means the
+// keys weren't a path.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+std::optional<std::vector<std::string>> replayKeys(const Board<num_rows, num_cols>& initial,
+    const std::vector<typename Codec::KeyType>& keys,
+    const MoveTable<num_rows, num_cols>& moves, const Codec& codec,
+    const SymmetryGroup<num_rows, num_cols>& symmetries, bool canonicalize) {
+  Board<num_rows, num_cols> board = initial;
+  std::vector<std::string> ret;
+  for (size_t step = 1; step < keys.size(); ++step) {
+    const size_t length = ret.size();
+    for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+      const Permutation<num_rows, num_cols>* permutation =
+          moves.permutation(board, move);
+      if (!permutation) {
+        continue;
+      }
+      Board<num_rows, num_cols> next = permutation->apply(board);
+      if (codec.encode(canonicalize ? symmetries.canonical(next) : next) ==
+          keys[step]) {
+        board = next;
+        ret.push_back(moveToString<num_rows>(move));
+        break;
+      }
+    }
+    if (ret.size() == length) {
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+// Same as joinPaths for searches that kept only canonical boards. Their nodes
+// stand for every board symmetric to them and the moves they record lead
+// between those sets rather than between boards, so this retraces the same
+// sets from |initial|. The last set holds only |win| since symmetries fix it.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+std::optional<std::vector<std::string>> replayPath(const Board<num_rows, num_cols>& initial,
+    const LayeredSearch<typename Codec::KeyType>& fwd, uint32_t fwd_index,
+    const LayeredSearch<typename Codec::KeyType>& bwd, uint32_t bwd_index,
+    const MoveTable<num_rows, num_cols>& moves, const Codec& codec,
+    const SymmetryGroup<num_rows, num_cols>& symmetries) {
+  std::vector<typename Codec::KeyType> keys = keysTo(fwd, fwd_index);
+  std::vector<typename Codec::KeyType> bwd_keys = keysTo(bwd, bwd_index);
+  // Both end with the key they met at.
+  keys.insert(keys.end(), bwd_keys.rbegin() + 1, bwd_keys.rend());
+  return replayKeys(initial, keys, moves, codec, symmetries, true);
+}
+
+// Records a path the search found, or an error if it couldn't be retraced.
+inline void setPath(MitmResult& result,
+                    std::optional<std::vector<std::string>> path) {
+  if (!path) {
+    result.error = "Couldn't retrace the moves of the path that was found";
+    return;
+  }
+  result.solved = true;
+  result.path = std::move(*path);
+}
+
+// Where a depth first search from one side's nodes reached the other side.
+template<typename Key>
+struct DeepeningMeeting {
+  // Index of the node the search started from.
+  uint32_t root;
+  // The keys reached from it in order, the last of which the other side has.
+  std::vector<Key> keys;
+  // Index of that node on the other side.
+  uint32_t other_index;
+};
+
+// Depth first search from the nodes of one side of a meet-in-the-middle
+// search, looking for boards the other side has. It keeps only the current
+// path, so it's what's left once the sides can't grow.
+template<typename Key, typename Neighbors>
+class FrontierDeepening {
+ public:
+  // |backward| says whether |side| searches from the goal. |neighbors| is as
+  // for LayeredSearch::expandLayer and must take the last move.
+  FrontierDeepening(const LayeredSearch<Key>& side, bool backward,
+                    const LayeredSearch<Key>& other,
+                    const Neighbors& neighbors)
+      : side_(side), backward_(backward), other_(other),
+        neighbors_(neighbors) {}
+
+  // Looks at every board exactly |depth| moves from the nodes in [begin,
+  // end), stopping at the first that the other side has.
+  std::optional<DeepeningMeeting<Key>> search(uint32_t begin, uint32_t end,
+                                              int depth) {
+    reached_ = false;
+    for (uint32_t root = begin; root < end; ++root) {
+      const SearchNode<Key>& node = side_.nodes()[root];
+      const int last_move = node.parent == root ? -1
+                            : backward_         ? node.move ^ 1
+                                                : node.move;
+      keys_.clear();
+      if (visit(node.key, last_move, depth)) {
+        return DeepeningMeeting<Key>{root, keys_, match_};
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Whether the last search() reached any board at its full depth. If not,
+  // deeper searches won't either.
+  bool reachedAny() const { return reached_; }
+  // Number of boards whose neighbors were generated so far.
+  size_t expanded() const { return expanded_; }
+
+ private:
+  bool visit(const Key& key, int last_move, int depth) {
+    ++expanded_;
+    const auto next = neighbors_(key, last_move);
+    for (size_t move = 0; move < next.size(); ++move) {
+      // Skipped and disallowed moves give back |key|.
+      if (next[move] == key) {
+        continue;
+      }
+      keys_.push_back(next[move]);
+      if (depth == 1) {
+        reached_ = true;
+        if (auto match = other_.find(next[move], other_.hash(next[move]))) {
+          match_ = *match;
+          return true;
+        }
+      } else if (visit(next[move], move, depth - 1)) {
+        return true;
+      }
+      keys_.pop_back();
+    }
+    return false;
+  }
+
+  const LayeredSearch<Key>& side_;
+  bool backward_;
+  const LayeredSearch<Key>& other_;
+  const Neighbors& neighbors_;
+  std::vector<Key> keys_;
+  uint32_t match_ = 0;
+  bool reached_ = false;
+  size_t expanded_ = 0;
+};
+
+// Goes on with a search whose sides can't grow any more, by depth first
+// search from the layer [layer_begin, layer_end) of the forward side if
+// |forward| and the backward side otherwise.
+//
+// Say that layer is a moves from its side's root and the other side has every
+// board within b of its own. They haven't met, so the shortest path is longer
+// than a + b. Searching k moves past the layer reaches every board a + k from
+// the first root, since every such board's path passes through the layer. If
+// none of them are on the other side, the shortest path is longer than
+// a + b + k. So each k is tried in turn, and the first match, which is then
+// exactly b from the other root, gives a shortest path of length a + b + k.
+template<std::size_t num_rows, std::size_t num_cols, typename Codec,
+         typename Neighbors>
+MitmResult deepenWithinBudget(const Board<num_rows, num_cols>& initial,
+    const LayeredSearch<typename Codec::KeyType>& fwd,
+    const LayeredSearch<typename Codec::KeyType>& bwd, bool forward,
+    size_t layer_begin, size_t layer_end, const Neighbors& neighbors,
+    const MoveTable<num_rows, num_cols>& moves, const Codec& codec,
+    const SymmetryGroup<num_rows, num_cols>& symmetries, bool canonicalize,
+    const MitmBudget& budget, MitmResult result) {
+  using Key = typename Codec::KeyType;
+  const LayeredSearch<Key>& side = forward ? fwd : bwd;
+  const LayeredSearch<Key>& other = forward ? bwd : fwd;
+  const int a = side.movesTo(layer_begin).size();
+  const int b = other.movesTo(other.nodes().size() - 1).size();
+  FrontierDeepening<Key, Neighbors> deepening(side, !forward, other,
+                                              neighbors);
+  const size_t states_expanded = result.states_expanded;
+  for (int k = 1;; ++k) {
+    if (a + b + k > budget.max_depth) {
+      result.lower_bound = a + b + k;
+      break;
+    }
+    auto meeting = deepening.search(layer_begin, layer_end, k);
+    result.states_expanded = states_expanded + deepening.expanded();
+    if (meeting) {
+      std::vector<Key> keys;
+      std::vector<Key> to_root = keysTo(side, meeting->root);
+      std::vector<Key> to_match = keysTo(other, meeting->other_index);
+      // The match is the last of meeting->keys and the last of to_match.
+      if (forward) {
+        keys = to_root;
+        keys.insert(keys.end(), meeting->keys.begin(), meeting->keys.end());
+        keys.insert(keys.end(), to_match.rbegin() + 1, to_match.rend());
+      } else {
+        keys = to_match;
+        keys.insert(keys.end(), meeting->keys.rbegin() + 1,
+                    meeting->keys.rend());
+        keys.insert(keys.end(), to_root.rbegin(), to_root.rend());
+      }
+      setPath(result, replayKeys(initial, keys, moves, codec, symmetries,
+                                 canonicalize));
+      break;
+    }
+    if (!deepening.reachedAny()) {
+      break;
+    }
+  }
+  return result;
+}
+
+template<std::size_t num_rows, std::size_t num_cols, typename Codec>
+MitmResult solveMitmWithCodec(const Board<num_rows, num_cols>& initial,
+    const Board<num_rows, num_cols>& win, const Rules& rules,
+    const Codec& codec, int threads, bool use_symmetry,
+    const CheckpointOptions& checkpoint, const MitmBudget& budget) {
+  using Key = typename Codec::KeyType;
+  MitmResult result;
+  MoveTable<num_rows, num_cols> moves(rules);
+  // Symmetries that fix the goal keep distances to it, so both sides can
+  // search the sets of symmetric boards instead of boards. The forward side
+  // then finds the fewest moves to any board in a set, which is all a
+  // shortest path through it needs.
+  SymmetryGroup<num_rows, num_cols> symmetries(moves, win);
+  const bool canonicalize = use_symmetry && symmetries.size() > 1;
+  // Each side should only need to reach about the square root of the state
+  // space before they meet.
+  size_t expected = std::min<double>(
+      std::sqrt(countArrangements(fromBoard(initial))), kMaxReserve);
+  // Leave most of a budget for growing.
+  while (budget.max_memory && expected > 1 &&
+         4 * LayeredSearch<Key>::memoryUsageFor(expected) >
+             budget.max_memory) {
+    expected /= 2;
+  }
+
+  LayeredSearch<Key> fwd(
+      codec.encode(canonicalize ? symmetries.canonical(initial) : initial),
+      expected, threads);
+  LayeredSearch<Key> bwd(codec.encode(win), expected, threads);
+  MovePruning<num_rows, num_cols> pruning(moves);
+  auto neighbors = [&](const Key& key, int last_move) {
+    if (canonicalize) {
+      return exploreCanonicalNeighbors(codec.decode(key), key, moves, pruning,
+                                       codec, symmetries);
+    }
+    return exploreNeighbors(codec.decode(key), key, last_move, moves, pruning,
+                            codec);
+  };
+  auto path = [&](uint32_t fwd_index, uint32_t bwd_index)
+      -> std::optional<std::vector<std::string>> {
+    if (canonicalize) {
+      return replayPath(initial, fwd, fwd_index, bwd, bwd_index, moves, codec,
+                        symmetries);
+    }
+    return joinPaths<num_rows>(fwd, fwd_index, bwd, bwd_index);
+  };
+  // The most nodes |side| can grow to while both sides fit in the budget.
+  auto maxNodes = [&](const LayeredSearch<Key>& side,
+                      const LayeredSearch<Key>& other) {
+    if (!budget.max_memory) {
+      return SIZE_MAX;
+    }
+    return side.maxNodesWithin(
+        budget.max_memory - std::min(budget.max_memory, other.memoryUsage()));
+  };
+
+  auto finish = [&]() {
+    result.states_expanded = fwd.expanded() + bwd.expanded();
+    result.peak_bytes = std::max(result.peak_bytes,
+        fwd.memoryUsage() + bwd.memoryUsage());
+    return result;
+  };
+
+  // Threads don't change what's found, so they're left out.
+  Checkpointer checkpointer(checkpoint,
+      "mitm " + std::to_string(num_rows) + "x" + std::to_string(num_cols) +
+      " " + modesToString(rules.row_mode, rules.col_mode, rules.validation) +
+      " " + boardToString(initial, rules.row_mode, ",") + " " +
+      boardToString(win, rules.row_mode, ",") +
+      (canonicalize ? " symmetry" : "") + " key " +
+      std::to_string(sizeof(Key)));
+  if (checkpointer.resume([&](SnapshotReader& reader) {
+        return fwd.load(reader) && bwd.load(reader) &&
+               reader.read(result.peak_bytes);
+      }) == Checkpointer::Resume::FAILED) {
+    result.error = "Couldn't resume from " + checkpointer.path();
+    return result;
+  }
+
+  // Expand whichever side has the smaller frontier, since that's the cheaper
+  // layer to generate; with validation the two sides can branch very
+  // differently. If either side runs out of states before they meet, there's
+  // no path.
+  //
+  // The first new node found on the other side gives a shortest path. Say the
+  // side being expanded has reached every state within a moves and the other
+  // side every state within b, and they haven't met, so the shortest path is
+  // longer than a + b. Any node in this layer that the other side has is at
+  // a + 1 from one end and, since its parent wasn't a match, exactly b from
+  // the other. So every match in the layer gives the same length, a + b + 1,
+  // and there's no point expanding the rest of it.
+  while (!fwd.done() && !bwd.done()) {
+    const bool forward = fwd.frontierSize() <= bwd.frontierSize();
+    LayeredSearch<Key>& side = forward ? fwd : bwd;
+    const LayeredSearch<Key>& other = forward ? bwd : fwd;
+    const size_t layer_begin = side.expanded();
+    const size_t layer_end = side.nodes().size();
+    // Searching backward, the move into a neighbor gets undone on the way to
+    // the goal.
+    if (auto meeting = side.expandLayer(neighbors, !forward, &other,
+                                        maxNodes(side, other))) {
+      setPath(result, forward ? path(meeting->index, meeting->other_index)
+                              : path(meeting->other_index, meeting->index));
+      return finish();
+    }
+    finish();
+    if (side.expanded() < layer_end) {
+      return deepenWithinBudget(initial, fwd, bwd, forward, layer_begin,
+                                layer_end, neighbors, moves, codec,
+                                symmetries, canonicalize, budget, result);
+    }
+    if (!checkpointer.maybeSave([&](SnapshotWriter& writer) {
+          fwd.save(writer);
+          bwd.save(writer);
+          writer.write(result.peak_bytes);
+        })) {
+      result.error = "Couldn't write checkpoint " + checkpointer.path();
+      return result;
+    }
+  }
+
+  return finish();
+}
+
+// Finds a shortest path from |initial| to |win|. With more than one thread,
+// each layer of the search is split between them; the result is the same.
+// With |use_symmetry|, boards that are symmetric with respect to the goal
+// are only searched once (see symmetry.h), which finds a path of the same
+// length but not necessarily the same path. With |checkpoint| set, the search
+// is saved between layers every so often and picks up from the last save if
+// there is one; see snapshot.h. |budget| bounds the memory the search takes,
+// past which it goes on more slowly.
+template<std::size_t num_rows, std::size_t num_cols>
+MitmResult solveMitm(const Board<num_rows, num_cols>& initial,
+    const Board<num_rows, num_cols>& win, const Rules& rules,
+    int threads = 1, bool use_symmetry = true,
+    const CheckpointOptions& checkpoint = {}, const MitmBudget& budget = {}) {
+  if (initial == win) {
+    MitmResult result;
+    result.solved = true;
+    return result;
+  }
+
+  CellAlphabet alphabet(fromBoard(initial));
+  return withCodec<num_rows, num_cols>(alphabet, [&](const auto& codec) {
+    return solveMitmWithCodec(initial, win, rules, codec, threads,
+                              use_symmetry, checkpoint, budget);
+  });
+}
+
+#endif
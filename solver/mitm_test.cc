@@ -0,0 +1,225 @@
+#include "mitm.h"
+
+#include <cstdio>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+// Applies a path in the app's notation to a board.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> applyPath(Board<num_rows, num_cols> board,
+                                    const std::vector<std::string> &path,
+                                    const Rules &rules) {
+  for (const std::string &move : path) {
+    bool forward = move.back() != '\'';
+    int offset = move[1] - '0';
+    if (move[0] == 'R') {
+      board = rowMove(board, offset, forward, rules.row_mode, rules.validation);
+    } else {
+      board = colMove(board, offset, forward, rules.col_mode, rules.validation);
+    }
+  }
+  return board;
+}
+
+TEST(Mitm, AlreadySolved) {
+  const Board<2, 2> b = {{
+      {{1, 2}},
+      {{2, 1}},
+  }};
+
+  MitmResult result = solveMitm(b, b, Rules());
+  EXPECT_TRUE(result.solved);
+  EXPECT_TRUE(result.path.empty());
+}
+
+TEST(Mitm, FindsOptimalPath) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 1 | FIXED}},
+  }};
+  const Board<3, 3> win = {{
+      {{1, 2, 3}},
+      {{1, 2, 3}},
+      {{1, 2, 1 | FIXED}},
+  }};
+  const Rules rules = {Mode::WIDE_1, Mode::WIDE_2, Validation::STATIC};
+
+  MitmResult result = solveMitm(initial, win, rules);
+  ASSERT_TRUE(result.solved);
+  EXPECT_EQ(applyPath(initial, result.path, rules), win);
+  EXPECT_EQ(result.path.size(), 7);
+}
+
+TEST(Mitm, Unsolvable) {
+  const Board<2, 2> initial = {{
+      {{1, 2 | FIXED}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> win = {{
+      {{2 | FIXED, 1}},
+      {{2, 1}},
+  }};
+  const Rules rules = {Mode::BASIC, Mode::BASIC, Validation::STATIC};
+
+  EXPECT_FALSE(solveMitm(initial, win, rules).solved);
+}
+
+TEST(Mitm, SymmetryKeepsLength) {
+  const Board<4, 4> initial = {{
+      {{1, 2, 3, 4}},
+      {{2, 3, 4, 1}},
+      {{3, 4, 1, 2}},
+      {{4, 1, 2, 3}},
+  }};
+  const Board<4, 4> win = {{
+      {{1, 1, 1, 1}},
+      {{2, 2, 2, 2}},
+      {{3, 3, 3, 3}},
+      {{4, 4, 4, 4}},
+  }};
+  for (const Rules &rules :
+       {Rules(), Rules{Mode::WIDE_2, Mode::BASIC, Validation::NONE},
+        Rules{Mode::CAROUSEL, Mode::CAROUSEL, Validation::NONE}}) {
+    MitmResult plain = solveMitm(initial, win, rules, 1, false);
+    MitmResult symmetric = solveMitm(initial, win, rules, 1, true);
+    ASSERT_TRUE(plain.solved);
+    ASSERT_TRUE(symmetric.solved);
+    EXPECT_EQ(applyPath(initial, symmetric.path, rules), win);
+    EXPECT_EQ(symmetric.path.size(), plain.path.size());
+    EXPECT_LT(symmetric.states_expanded, plain.states_expanded);
+  }
+}
+
+// Saving after every layer leaves the search from just before it met the
+// other side, and a second run picks up from there.
+TEST(Mitm, ResumesFromCheckpoint) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 1 | FIXED}},
+  }};
+  const Board<3, 3> win = {{
+      {{1, 2, 3}},
+      {{1, 2, 3}},
+      {{1, 2, 1 | FIXED}},
+  }};
+  const Rules rules = {Mode::WIDE_1, Mode::WIDE_2, Validation::STATIC};
+  const CheckpointOptions checkpoint{testing::TempDir() + "/mitm", 0};
+  std::remove(checkpoint.path.c_str());
+
+  MitmResult first = solveMitm(initial, win, rules, 1, true, checkpoint);
+  ASSERT_TRUE(first.solved);
+  EXPECT_TRUE(first.error.empty());
+  MitmResult resumed = solveMitm(initial, win, rules, 1, true, checkpoint);
+  ASSERT_TRUE(resumed.solved);
+  EXPECT_EQ(resumed.path, first.path);
+  EXPECT_EQ(resumed.states_expanded, first.states_expanded);
+
+  // The checkpoint is for another puzzle.
+  MitmResult other = solveMitm(win, initial, rules, 1, true, checkpoint);
+  EXPECT_FALSE(other.solved);
+  EXPECT_FALSE(other.error.empty());
+}
+
+// Out of memory, the search goes on by depth first search from one side's
+// frontier and still finds a shortest path.
+TEST(Mitm, FindsOptimalPathWithinBudget) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 1 | FIXED}},
+  }};
+  const Board<3, 3> win = {{
+      {{1, 2, 3}},
+      {{1, 2, 3}},
+      {{1, 2, 1 | FIXED}},
+  }};
+  for (const Rules &rules :
+       {Rules{Mode::WIDE_1, Mode::WIDE_2, Validation::STATIC},
+        Rules{Mode::BASIC, Mode::GEAR, Validation::NONE}}) {
+    for (bool use_symmetry : {false, true}) {
+      MitmResult unlimited = solveMitm(initial, win, rules, 1, use_symmetry);
+      ASSERT_TRUE(unlimited.solved);
+      const MitmBudget budget{unlimited.peak_bytes / 8, 100};
+      MitmResult limited =
+          solveMitm(initial, win, rules, 1, use_symmetry, {}, budget);
+      ASSERT_TRUE(limited.solved);
+      EXPECT_EQ(limited.path.size(), unlimited.path.size());
+      EXPECT_EQ(applyPath(initial, limited.path, rules), win);
+      EXPECT_LE(limited.peak_bytes, budget.max_memory);
+    }
+  }
+}
+
+// Short of memory and allowed length, the search reports how long a path must
+// be.
+TEST(Mitm, ReportsLowerBound) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 1 | FIXED}},
+  }};
+  const Board<3, 3> win = {{
+      {{1, 2, 3}},
+      {{1, 2, 3}},
+      {{1, 2, 1 | FIXED}},
+  }};
+  const Rules rules = {Mode::WIDE_1, Mode::WIDE_2, Validation::STATIC};
+  const size_t max_memory = solveMitm(initial, win, rules).peak_bytes / 8;
+  MitmResult result =
+      solveMitm(initial, win, rules, 1, true, {}, MitmBudget{max_memory, 4});
+  EXPECT_FALSE(result.solved);
+  EXPECT_EQ(result.lower_bound, 5);
+
+  // The same path is found once it's allowed.
+  result =
+      solveMitm(initial, win, rules, 1, true, {}, MitmBudget{max_memory, 7});
+  ASSERT_TRUE(result.solved);
+  EXPECT_EQ(result.path.size(), 7);
+}
+
+// Running out of boards to search still means there's no path.
+TEST(Mitm, UnsolvableWithinBudget) {
+  const Board<2, 2> initial = {{
+      {{1, 2 | FIXED}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> win = {{
+      {{2 | FIXED, 1}},
+      {{2, 1}},
+  }};
+  const Rules rules = {Mode::BASIC, Mode::BASIC, Validation::STATIC};
+  MitmResult result =
+      solveMitm(initial, win, rules, 1, true, {}, MitmBudget{1, 100});
+  EXPECT_FALSE(result.solved);
+  EXPECT_EQ(result.lower_bound, 0);
+}
+
+// Keys that aren't a path can't be retraced, and say so rather than skip the
+// step.
+TEST(Mitm, ReplayKeysNeedsAPath) {
+  const Board<2, 2> initial = {{
+      {{1, 2}},
+      {{3, 4}},
+  }};
+  const Rules rules = {Mode::BASIC, Mode::BASIC, Validation::NONE};
+  MoveTable<2, 2> moves(rules);
+  SymmetryGroup<2, 2> symmetries(moves, initial);
+  CellAlphabet alphabet(fromBoard(initial));
+  PackedCodec<2, 2, uint64_t> codec(alphabet);
+
+  Board<2, 2> moved = rowMove(initial, 0, true, rules.row_mode,
+                              rules.validation);
+  auto path = replayKeys(initial, {codec.encode(initial), codec.encode(moved)},
+                         moves, codec, symmetries, false);
+  ASSERT_TRUE(path.has_value());
+  EXPECT_EQ(applyPath(initial, *path, rules), moved);
+
+  // Two moves away.
+  Board<2, 2> far = colMove(moved, 0, true, rules.col_mode, rules.validation);
+  EXPECT_EQ(replayKeys(initial, {codec.encode(initial), codec.encode(far)},
+                       moves, codec, symmetries, false),
+            std::nullopt);
+}
@@ -0,0 +1,168 @@
+// Moves a search can skip, worked out once per puzzle from the move table.
+//
+// Three kinds of move are never needed:
+//  - Moves that do nothing (lines of length 1) or the same as the other
+//    direction of their line (lines of length 2). The latter only without
+//    validation, which can tell the directions apart.
+//  - Moves that undo the move just made, which only lead back.
+//  - Of two independent moves in a row, the one on the higher line first.
+//    Moves are independent if they slide lines of the same orientation and
+//    the lines each one carries are disjoint. Validation only looks at the
+//    lines a move carries, so either order is allowed and ends in the same
+//    place. BANDAGED moves look at bonds in the neighboring lines, so they're
+//    never independent.
+//
+// A depth first search can skip all of these: some shortest path to every
+// board avoids them all. A breadth first search that records a single move
+// into each node can skip them based on that move. If a skipped move would
+// have found a new node, swapping it with the independent move that reached
+// the current node gives another node in the same layer from which the
+// recorded move would have found it. That node's own recorded move is on a
+// higher line still, so this can't go on forever, and the new node is found
+// either way.
+#ifndef LOOPINGDICE_MOVE_PRUNING
+#define LOOPINGDICE_MOVE_PRUNING
+
+#include <array>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+#include "move_table.h"
+
+template <std::size_t num_rows, std::size_t num_cols> class MovePruning {
+public:
+  static constexpr int kNumMoves = ::kNumMoves<num_rows, num_cols>;
+
+  explicit MovePruning(const MoveTable<num_rows, num_cols> &moves) {
+    Board<num_rows, num_cols> labels;
+    for (size_t i = 0; i < num_rows * num_cols; ++i) {
+      labels[i / num_cols][i % num_cols] = i;
+    }
+    // The lines each move carries, over all its variants, and the board
+    // each variant leaves the labels in.
+    std::array<std::vector<bool>, kNumMoves> lines;
+    std::array<std::vector<Board<num_rows, num_cols>>, kNumMoves> moved;
+    for (int move = 0; move < kNumMoves; ++move) {
+      bool is_row = isRow(move);
+      lines[move].resize(is_row ? num_rows : num_cols);
+      bool does_nothing = true;
+      moves.forEachVariant(
+          move, [&](const Permutation<num_rows, num_cols> &permutation) {
+            for (size_t i = 0; i < permutation.size; ++i) {
+              lines[move][is_row ? permutation.to[i] / num_cols
+                                 : permutation.to[i] % num_cols] = true;
+            }
+            does_nothing = does_nothing && permutation.size == 0;
+            moved[move].push_back(permutation.apply(labels));
+          });
+      unneeded_[move] = does_nothing;
+    }
+
+    const Rules &rules = moves.rules();
+    for (int move = 1; move < kNumMoves; move += 2) {
+      // Backward is the odd one.
+      if (rules.validation == Validation::NONE &&
+          moved[move] == moved[move ^ 1]) {
+        unneeded_[move] = true;
+      }
+    }
+
+    for (int last = 0; last < kNumMoves; ++last) {
+      Mode mode = isRow(last) ? rules.row_mode : rules.col_mode;
+      for (int move = 0; move < kNumMoves; ++move) {
+        bool independent = mode != Mode::BANDAGED &&
+                           isRow(move) == isRow(last) &&
+                           disjoint(lines[move], lines[last]);
+        skip_[last][move] = unneeded_[move] ||
+                            undoes(moved[move], moved[last], labels) ||
+                            (independent && move / 2 < last / 2);
+      }
+    }
+  }
+
+  // Whether |move| can be skipped right after |last|, which is -1 at the
+  // start of a path.
+  bool skip(int last, int move) const {
+    return last < 0 ? unneeded_[move] : skip_[last][move];
+  }
+
+  // The average number of moves left after each move that's ever made,
+  // which is what the branching factor of a search drops to.
+  double branchingFactor() const {
+    int total = 0;
+    int made = 0;
+    for (int last = 0; last < kNumMoves; ++last) {
+      if (unneeded_[last]) {
+        continue;
+      }
+      ++made;
+      for (int move = 0; move < kNumMoves; ++move) {
+        total += !skip_[last][move];
+      }
+    }
+    return made == 0 ? 0 : static_cast<double>(total) / made;
+  }
+
+private:
+  static bool isRow(int move) {
+    return move / 2 < static_cast<int>(num_rows);
+  }
+
+  // Whether each variant of a move, which leaves the labels as in
+  // |moved|, undoes the same variant of the move that left them as in
+  // |last|. That's the inverse, and for lines of length 2 the move itself.
+  // The variant a move picks only depends on the cells it carries, so
+  // whichever one the last move picked, this one picks the same.
+  static bool undoes(const std::vector<Board<num_rows, num_cols>> &moved,
+                     const std::vector<Board<num_rows, num_cols>> &last,
+                     const Board<num_rows, num_cols> &labels) {
+    if (moved.size() != last.size()) {
+      return false;
+    }
+    for (size_t variant = 0; variant < moved.size(); ++variant) {
+      Permutation<num_rows, num_cols> permutation =
+          Permutation<num_rows, num_cols>::fromLabels(moved[variant]);
+      if (permutation.apply(last[variant]) != labels) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool disjoint(const std::vector<bool> &a, const std::vector<bool> &b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i] && b[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::array<bool, kNumMoves> unneeded_;
+  // skip_[last][move] is whether |move| can be skipped after |last|.
+  std::array<std::array<bool, kNumMoves>, kNumMoves> skip_;
+};
+
+// The keys of a board's neighbors, indexed by move number. Moves that
+// |pruning| skips after |last_move|, and ones that aren't allowed, give back
+// |key|.
+template <std::size_t num_rows, std::size_t num_cols, typename Codec>
+std::array<typename Codec::KeyType, kNumMoves<num_rows, num_cols>>
+exploreNeighbors(const Board<num_rows, num_cols> &board,
+                 const typename Codec::KeyType &key, int last_move,
+                 const MoveTable<num_rows, num_cols> &moves,
+                 const MovePruning<num_rows, num_cols> &pruning,
+                 const Codec &codec) {
+  std::array<typename Codec::KeyType, kNumMoves<num_rows, num_cols>> ret;
+  const LineFlags<num_rows, num_cols> lines = moves.lineFlags(board);
+  for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+    ret[move] = pruning.skip(last_move, move)
+                    ? key
+                    : codec.move(key, board,
+                                 moves.permutation(board, lines, move));
+  }
+  return ret;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "move_pruning.h"
+
+#include <map>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "move_table.h"
+
+namespace {
+
+// A board with a few colors and every kind of flag sprinkled around.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> randomBoard(std::mt19937 &rng) {
+  const int flags[] = {HORIZ, VERT,      UP,    DOWN,   LEFT,
+                       RIGHT, LIGHTNING, FIXED, ENABLER};
+  Board<num_rows, num_cols> board;
+  for (auto &row : board) {
+    for (int &cell : row) {
+      cell = rng() % 4;
+      for (int flag : flags) {
+        if (rng() % 8 == 0) {
+          cell |= flag;
+        }
+      }
+    }
+  }
+  return board;
+}
+
+// The board after |move|, or nothing if it isn't allowed.
+template <std::size_t num_rows, std::size_t num_cols>
+std::optional<Board<num_rows, num_cols>>
+applyMove(const MoveTable<num_rows, num_cols> &moves,
+          const Board<num_rows, num_cols> &board, int move) {
+  const Permutation<num_rows, num_cols> *permutation =
+      moves.permutation(board, move);
+  if (!permutation) {
+    return std::nullopt;
+  }
+  return permutation->apply(board);
+}
+
+// Checks that every move skipped is one of the kinds move_pruning.h
+// describes, on some random boards.
+template <std::size_t num_rows, std::size_t num_cols> void checkAllModes() {
+  const Mode modes[] = {Mode::BASIC,  Mode::WIDE_2,   Mode::WIDE_3,
+                        Mode::WIDE_4, Mode::GEAR,     Mode::CAROUSEL,
+                        Mode::BANDAGED, Mode::LIGHTNING};
+  constexpr int kNumMoves = ::kNumMoves<num_rows, num_cols>;
+  std::mt19937 rng(num_rows * 10 + num_cols);
+  for (Mode mode : modes) {
+    if (!moveFits(mode, num_rows) || !moveFits(mode, num_cols)) {
+      continue;
+    }
+    for (int validation = 0; validation < 16; ++validation) {
+      Rules rules{mode, mode, static_cast<Validation>(validation)};
+      MoveTable<num_rows, num_cols> moves(rules);
+      MovePruning<num_rows, num_cols> pruning(moves);
+      for (int i = 0; i < 20; ++i) {
+        Board<num_rows, num_cols> board = randomBoard<num_rows, num_cols>(rng);
+        for (int move = 0; move < kNumMoves; ++move) {
+          if (!pruning.skip(-1, move)) {
+            continue;
+          }
+          // Does nothing, or the same as the other direction.
+          auto moved = applyMove(moves, board, move);
+          EXPECT_TRUE(!moved || *moved == board ||
+                      moved == applyMove(moves, board, move ^ 1))
+              << modesToString(mode, mode, rules.validation) << " " << move;
+        }
+        for (int last = 0; last < kNumMoves; ++last) {
+          auto after_last = applyMove(moves, board, last);
+          if (!after_last) {
+            continue;
+          }
+          for (int move = 0; move < kNumMoves; ++move) {
+            if (!pruning.skip(last, move) || pruning.skip(-1, move)) {
+              continue;
+            }
+            // Skipping a move is only a loss if it's allowed and goes
+            // somewhere new.
+            auto after_both = applyMove(moves, *after_last, move);
+            if (!after_both || *after_both == board) {
+              continue;
+            }
+            // Independent: the other order is allowed and gets to the same
+            // place.
+            EXPECT_LT(move / 2, last / 2);
+            auto after_move = applyMove(moves, board, move);
+            std::optional<Board<num_rows, num_cols>> swapped;
+            if (after_move) {
+              swapped = applyMove(moves, *after_move, last);
+            }
+            EXPECT_EQ(after_both, swapped)
+                << modesToString(mode, mode, rules.validation) << " " << last
+                << " then " << move;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Counts the boards at each depth from |initial|, skipping moves after the
+// one recorded for each board if |pruning| is set. If |recorded| is set, it
+// gets the move recorded for each board.
+template <std::size_t num_rows, std::size_t num_cols>
+std::vector<int>
+layerSizes(const Board<num_rows, num_cols> &initial,
+           const MoveTable<num_rows, num_cols> &moves,
+           const MovePruning<num_rows, num_cols> *pruning,
+           std::map<Board<num_rows, num_cols>, int> *recorded = nullptr) {
+  std::map<Board<num_rows, num_cols>, int> last_move = {{initial, -1}};
+  std::vector<Board<num_rows, num_cols>> layer = {initial};
+  std::vector<int> ret;
+  while (!layer.empty()) {
+    ret.push_back(layer.size());
+    std::vector<Board<num_rows, num_cols>> next;
+    for (const auto &board : layer) {
+      for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+        if (pruning && pruning->skip(last_move[board], move)) {
+          continue;
+        }
+        auto moved = applyMove(moves, board, move);
+        if (moved && last_move.emplace(*moved, move).second) {
+          next.push_back(*moved);
+        }
+      }
+    }
+    layer = std::move(next);
+  }
+  if (recorded) {
+    *recorded = std::move(last_move);
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(MovePruning, SkipsOnlyRedundantMoves) {
+  checkAllModes<2, 2>();
+  checkAllModes<3, 4>();
+  checkAllModes<4, 4>();
+}
+
+TEST(MovePruning, BreadthFirstFindsEverything) {
+  const Board<3, 3> initial = {{
+      {{1, 1, 2}},
+      {{2, 3 | FIXED, 3}},
+      {{1, 2 | ENABLER, 3}},
+  }};
+  for (Mode mode : {Mode::BASIC, Mode::GEAR, Mode::CAROUSEL}) {
+    for (Validation validation : {Validation::NONE, Validation::STATIC,
+                                  Validation::DYNAMIC, Validation::ENABLER}) {
+      MoveTable<3, 3> moves(Rules{mode, Mode::BASIC, validation});
+      MovePruning<3, 3> pruning(moves);
+      std::vector<int> pruned = layerSizes(initial, moves, &pruning);
+      std::vector<int> plain = layerSizes<3, 3>(initial, moves, nullptr);
+      EXPECT_EQ(pruned, plain) << modesToString(mode, Mode::BASIC, validation);
+    }
+  }
+}
+
+// Every board is first found by the same move from the same board either
+// way, so the paths bfs prints don't change.
+TEST(MovePruning, BreadthFirstRecordsSameMoves) {
+  const Board<2, 3> initial = {{
+      {{1 | RIGHT, 1 | LEFT | DOWN, 2 | FIXED}},
+      {{2 | ENABLER, 1 | UP, 2 | HORIZ}},
+  }};
+  for (Mode mode : {Mode::BASIC, Mode::WIDE_2, Mode::GEAR, Mode::CAROUSEL,
+                    Mode::BANDAGED}) {
+    for (Validation validation :
+         {Validation::NONE, Validation::STATIC, Validation::DYNAMIC,
+          Validation::ENABLER, Validation::ARROWS}) {
+      MoveTable<2, 3> moves(Rules{mode, Mode::BASIC, validation});
+      MovePruning<2, 3> pruning(moves);
+      std::map<Board<2, 3>, int> pruned, plain;
+      layerSizes(initial, moves, &pruning, &pruned);
+      layerSizes<2, 3>(initial, moves, nullptr, &plain);
+      EXPECT_EQ(pruned, plain) << modesToString(mode, Mode::BASIC, validation);
+    }
+  }
+}
+
+TEST(MovePruning, BranchingFactor) {
+  // Two lines of length 2 each way: forward and backward are the same, a
+  // move undoes itself, and the other line of the same orientation can only
+  // come after.
+  MovePruning<2, 2> small((MoveTable<2, 2>(Rules())));
+  EXPECT_DOUBLE_EQ(small.branchingFactor(), 2.5);
+  // Without pruning it would be 12.
+  MovePruning<3, 3> basic((MoveTable<3, 3>(Rules())));
+  EXPECT_LT(basic.branchingFactor(), 12);
+}
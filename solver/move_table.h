@@ -0,0 +1,408 @@
+// Precomputed moves for a fixed board size and set of rules.
+//
+// Without validation every move is a fixed permutation of the board's cells,
+// so rather than shuffling cells around with slideRow and slideCol on every
+// call, MoveTable works out each permutation once and applies it by copying
+// only the cells that move. Validation still looks at the board, as do
+// LIGHTNING and BANDAGED moves, which pick between a few precomputed
+// permutations depending on the cells in the moved rows.
+#ifndef LOOPINGDICE_MOVE_TABLE
+#define LOOPINGDICE_MOVE_TABLE
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+#include "moves.h"
+#include "puzzle.h"
+
+// The cells changed by a move. Cells are numbered row-major, and cell to[i] of
+// the moved board is cell from[i] of the original.
+template <std::size_t num_rows, std::size_t num_cols> struct Permutation {
+  static_assert(num_rows * num_cols <= 256, "Cell indices must fit in a byte");
+
+  std::array<uint8_t, num_rows * num_cols> to;
+  std::array<uint8_t, num_rows * num_cols> from;
+  size_t size = 0;
+
+  // Finds the permutation that was applied to a board whose cells were their
+  // own indices to get |moved|.
+  static Permutation fromLabels(const Board<num_rows, num_cols> &moved) {
+    Permutation ret;
+    for (size_t i = 0; i < num_rows * num_cols; ++i) {
+      int source = moved[i / num_cols][i % num_cols];
+      if (source != static_cast<int>(i)) {
+        ret.to[ret.size] = i;
+        ret.from[ret.size] = source;
+        ++ret.size;
+      }
+    }
+    return ret;
+  }
+
+  Board<num_rows, num_cols> apply(const Board<num_rows, num_cols> &board) const {
+    Board<num_rows, num_cols> ret = board;
+    for (size_t i = 0; i < size; ++i) {
+      ret[to[i] / num_cols][to[i] % num_cols] =
+          board[from[i] / num_cols][from[i] % num_cols];
+    }
+    return ret;
+  }
+};
+
+// Moves can be referred to by a single number: row moves first, then column
+// moves, each forward and then backward. So on a board with R rows, move 2 * r
+// is row r forward, 2 * r + 1 is row r backward and 2 * (R + c) is column c
+// forward. A move's inverse is the move number XOR 1.
+template <std::size_t num_rows, std::size_t num_cols>
+constexpr int kNumMoves = 2 * (num_rows + num_cols);
+
+// Formats a move number in the notation the app uses, e.g. "R0" or "C2'".
+template <std::size_t num_rows>
+std::string moveToString(int move) {
+  int line = move / 2;
+  std::string ret = line < static_cast<int>(num_rows)
+                        ? "R" + std::to_string(line)
+                        : "C" + std::to_string(line - num_rows);
+  return move % 2 ? ret + "'" : ret;
+}
+
+// A drop in replacement for rowMove and colMove in moves.h for one puzzle.
+template <std::size_t num_rows, std::size_t num_cols> class MoveTable {
+public:
+  explicit MoveTable(const Rules &rules)
+      : rules_(rules), row_variants_(numVariants(rules.row_mode, num_rows)),
+        col_variants_(numVariants(rules.col_mode, num_cols)),
+        row_permutation_(
+            pickPermutation<true>(rules.row_mode, rules.validation)),
+        col_permutation_(
+            pickPermutation<false>(rules.col_mode, rules.validation)) {
+    Board<num_rows, num_cols> labels;
+    for (size_t i = 0; i < num_rows * num_cols; ++i) {
+      labels[i / num_cols][i % num_cols] = i;
+    }
+
+    for (size_t row = 0; row < num_rows; ++row) {
+      for (int variant = 0; variant < row_variants_; ++variant) {
+        for (bool forward : {false, true}) {
+          row_moves_.push_back(Permutation<num_rows, num_cols>::fromLabels(
+              labelledRowMove(labels, row, forward, variant)));
+        }
+      }
+    }
+    for (size_t col = 0; col < num_cols; ++col) {
+      for (int variant = 0; variant < col_variants_; ++variant) {
+        for (bool forward : {false, true}) {
+          col_moves_.push_back(Permutation<num_rows, num_cols>::fromLabels(
+              labelledColMove(labels, col, forward, variant)));
+        }
+      }
+    }
+  }
+
+  const Rules &rules() const { return rules_; }
+
+  // Calls f(permutation, is_row_move) for every permutation any move can
+  // apply, whatever the board.
+  template <typename F> void forEachPermutation(const F &f) const {
+    for (const auto &permutation : row_moves_) {
+      f(permutation, true);
+    }
+    for (const auto &permutation : col_moves_) {
+      f(permutation, false);
+    }
+  }
+
+  // Calls f(permutation) for each permutation the move numbered |move| picks
+  // between depending on the board. BANDAGED moves can also start at
+  // another line, bonded to this one, which gives other permutations.
+  template <typename F> void forEachVariant(int move, const F &f) const {
+    bool forward = move % 2 == 0;
+    int line = move / 2;
+    if (line < static_cast<int>(num_rows)) {
+      for (int variant = 0; variant < row_variants_; ++variant) {
+        f(row_moves_[(line * row_variants_ + variant) * 2 + forward]);
+      }
+    } else {
+      line -= num_rows;
+      for (int variant = 0; variant < col_variants_; ++variant) {
+        f(col_moves_[(line * col_variants_ + variant) * 2 + forward]);
+      }
+    }
+  }
+
+  // Same as ::rowMove(board, offset, forward, rules.row_mode,
+  // rules.validation).
+  Board<num_rows, num_cols> rowMove(const Board<num_rows, num_cols> &board,
+                                    int offset, bool forward) const {
+    const Permutation<num_rows, num_cols> *permutation =
+        rowPermutation(board, offset, forward);
+    return permutation ? permutation->apply(board) : board;
+  }
+
+  // Same as ::colMove(board, offset, forward, rules.col_mode,
+  // rules.validation).
+  Board<num_rows, num_cols> colMove(const Board<num_rows, num_cols> &board,
+                                    int offset, bool forward) const {
+    const Permutation<num_rows, num_cols> *permutation =
+        colPermutation(board, offset, forward);
+    return permutation ? permutation->apply(board) : board;
+  }
+
+  // The permutation applied by the move numbered |move|, or nullptr if it
+  // isn't allowed.
+  const Permutation<num_rows, num_cols> *
+  permutation(const Board<num_rows, num_cols> &board, int move) const {
+    return permutation(board, lineFlags(board), move);
+  }
+
+  // Like permutation(board, move), with |lines| from lineFlags(board). Saves
+  // rescanning the board when trying every move of it.
+  const Permutation<num_rows, num_cols> *
+  permutation(const Board<num_rows, num_cols> &board,
+              const LineFlags<num_rows, num_cols> &lines, int move) const {
+    bool forward = move % 2 == 0;
+    int line = move / 2;
+    if (line < static_cast<int>(num_rows)) {
+      return rowPermutation(board, lines, line, forward);
+    }
+    return colPermutation(board, lines, line - num_rows, forward);
+  }
+
+  // What moves of |board| need to know about its lines to be validated. Left
+  // empty, without looking at the board, if the moves never depend on it.
+  LineFlags<num_rows, num_cols>
+  lineFlags(const Board<num_rows, num_cols> &board) const {
+    if (!row_permutation_ && !col_permutation_) {
+      return LineFlags<num_rows, num_cols>();
+    }
+    return LineFlags<num_rows, num_cols>(board);
+  }
+
+  // The permutation rowMove applies to |board|, or nullptr if the move isn't
+  // allowed. Lets callers update things derived from the board, like hashes,
+  // by looking at only the cells that move.
+  const Permutation<num_rows, num_cols> *
+  rowPermutation(const Board<num_rows, num_cols> &board, int offset,
+                 bool forward) const {
+    return rowPermutation(board, lineFlags(board), offset, forward);
+  }
+  const Permutation<num_rows, num_cols> *
+  rowPermutation(const Board<num_rows, num_cols> &board,
+                 const LineFlags<num_rows, num_cols> &lines, int offset,
+                 bool forward) const {
+    if (!row_permutation_) {
+      return &row_moves_[offset * 2 + forward];
+    }
+    return (this->*row_permutation_)(board, lines, offset, forward);
+  }
+
+  // Like rowPermutation but for colMove.
+  const Permutation<num_rows, num_cols> *
+  colPermutation(const Board<num_rows, num_cols> &board, int offset,
+                 bool forward) const {
+    return colPermutation(board, lineFlags(board), offset, forward);
+  }
+  const Permutation<num_rows, num_cols> *
+  colPermutation(const Board<num_rows, num_cols> &board,
+                 const LineFlags<num_rows, num_cols> &lines, int offset,
+                 bool forward) const {
+    if (!col_permutation_) {
+      return &col_moves_[offset * 2 + forward];
+    }
+    return (this->*col_permutation_)(board, lines, offset, forward);
+  }
+
+private:
+  // The number of permutations needed for each move. Bandaged moves can drag
+  // along any number of rows and lightning moves slide either once or twice.
+  static int numVariants(Mode mode, size_t size) {
+    switch (mode) {
+    case Mode::BANDAGED:
+      return size;
+    case Mode::LIGHTNING:
+      return 2;
+    default:
+      return 1;
+    }
+  }
+
+  Board<num_rows, num_cols>
+  labelledRowMove(const Board<num_rows, num_cols> &labels, int offset,
+                  bool forward, int variant) const {
+    switch (rules_.row_mode) {
+    case Mode::BANDAGED:
+      return wideRowMove(labels, offset, forward, Validation::NONE,
+                         variant + 1);
+    case Mode::LIGHTNING: {
+      Board<num_rows, num_cols> ret = labels;
+      for (int i = 0; i <= variant; ++i) {
+        slideRow(ret, offset, forward);
+      }
+      return ret;
+    }
+    default:
+      return ::rowMove(labels, offset, forward, rules_.row_mode,
+                       Validation::NONE);
+    }
+  }
+
+  Board<num_rows, num_cols>
+  labelledColMove(const Board<num_rows, num_cols> &labels, int offset,
+                  bool forward, int variant) const {
+    switch (rules_.col_mode) {
+    case Mode::BANDAGED:
+      return wideColMove(labels, offset, forward, Validation::NONE,
+                         variant + 1);
+    case Mode::LIGHTNING: {
+      Board<num_rows, num_cols> ret = labels;
+      for (int i = 0; i <= variant; ++i) {
+        slideCol(ret, offset, forward);
+      }
+      return ret;
+    }
+    default:
+      return ::colMove(labels, offset, forward, rules_.col_mode,
+                       Validation::NONE);
+    }
+  }
+
+  using PermutationFn = const Permutation<num_rows, num_cols> *(
+      MoveTable::*)(const Board<num_rows, num_cols> &,
+                    const LineFlags<num_rows, num_cols> &, int, bool) const;
+
+  // The mode and validation are fixed for a puzzle, so rather than switching
+  // on them for every move, the constructor picks a version of rowPermutation
+  // and colPermutation compiled for them, in which the checks for other
+  // modes and validations are gone. Modes are grouped the way their moves
+  // are looked up: BASIC and the WIDE modes only differ in depth. Moves that
+  // never look at the board get no function, so they're a plain lookup.
+  template <bool kRow>
+  static PermutationFn pickPermutation(Mode mode, Validation validation) {
+    if (validation == Validation::NONE && mode != Mode::BANDAGED &&
+        mode != Mode::LIGHTNING) {
+      return nullptr;
+    }
+    switch (mode) {
+    case Mode::GEAR:
+      return pickValidation<kRow, Mode::GEAR>(validation);
+    case Mode::CAROUSEL:
+      return pickValidation<kRow, Mode::CAROUSEL>(validation);
+    case Mode::BANDAGED:
+      return pickValidation<kRow, Mode::BANDAGED>(validation);
+    case Mode::LIGHTNING:
+      return pickValidation<kRow, Mode::LIGHTNING>(validation);
+    default:
+      return pickValidation<kRow, Mode::BASIC>(validation);
+    }
+  }
+
+  template <bool kRow, Mode kMode>
+  static PermutationFn pickValidation(Validation validation) {
+    return pickValidationImpl<kRow, kMode>(validation,
+                                           std::make_index_sequence<16>());
+  }
+
+  template <bool kRow, Mode kMode, std::size_t... kValidations>
+  static PermutationFn
+  pickValidationImpl(Validation validation,
+                     std::index_sequence<kValidations...>) {
+    static constexpr PermutationFn table[] = {
+        (kRow ? &MoveTable::rowPermutationFor<
+                    kMode, static_cast<Validation>(kValidations)>
+              : &MoveTable::colPermutationFor<
+                    kMode, static_cast<Validation>(kValidations)>)...};
+    return table[static_cast<int>(validation)];
+  }
+
+  template <Mode kMode, Validation kValidation>
+  const Permutation<num_rows, num_cols> *
+  rowPermutationFor(const Board<num_rows, num_cols> &board,
+                    const LineFlags<num_rows, num_cols> &lines, int offset,
+                    bool forward) const {
+    int variant = 0;
+    if constexpr (kMode == Mode::BANDAGED) {
+      auto [first, depth] = bandagedRowExtent(lines, offset);
+      if (!validateWideRowMove(board, lines, first, forward, kValidation,
+                               depth)) {
+        return nullptr;
+      }
+      offset = (first + num_rows) % num_rows;
+      variant = depth - 1;
+    } else if constexpr (kMode == Mode::LIGHTNING) {
+      if (!validateLightningRowMove(board, lines, offset, forward,
+                                    kValidation)) {
+        return nullptr;
+      }
+      variant = row_contains_lightning(lines, offset) ? 1 : 0;
+    } else if constexpr (kMode == Mode::GEAR) {
+      if (!validateGearRowMove(board, lines, offset, forward,
+                               kValidation)) {
+        return nullptr;
+      }
+    } else if constexpr (kMode == Mode::CAROUSEL) {
+      if (!validateCarouselRowMove(board, lines, offset, forward,
+                                   kValidation)) {
+        return nullptr;
+      }
+    } else if (!validateWideRowMove(board, lines, offset, forward,
+                                    kValidation,
+                                    static_cast<int>(rules_.row_mode))) {
+      return nullptr;
+    }
+    return &row_moves_[(offset * row_variants_ + variant) * 2 + forward];
+  }
+
+  template <Mode kMode, Validation kValidation>
+  const Permutation<num_rows, num_cols> *
+  colPermutationFor(const Board<num_rows, num_cols> &board,
+                    const LineFlags<num_rows, num_cols> &lines, int offset,
+                    bool forward) const {
+    int variant = 0;
+    if constexpr (kMode == Mode::BANDAGED) {
+      auto [first, depth] = bandagedColExtent(lines, offset);
+      if (!validateWideColMove(board, lines, first, forward, kValidation,
+                               depth)) {
+        return nullptr;
+      }
+      offset = (first + num_cols) % num_cols;
+      variant = depth - 1;
+    } else if constexpr (kMode == Mode::LIGHTNING) {
+      if (!validateLightningColMove(board, lines, offset, forward,
+                                    kValidation)) {
+        return nullptr;
+      }
+      variant = col_contains_lightning(lines, offset) ? 1 : 0;
+    } else if constexpr (kMode == Mode::GEAR) {
+      if (!validateGearColMove(board, lines, offset, forward,
+                               kValidation)) {
+        return nullptr;
+      }
+    } else if constexpr (kMode == Mode::CAROUSEL) {
+      if (!validateCarouselColMove(board, lines, offset, forward,
+                                   kValidation)) {
+        return nullptr;
+      }
+    } else if (!validateWideColMove(board, lines, offset, forward,
+                                    kValidation,
+                                    static_cast<int>(rules_.col_mode))) {
+      return nullptr;
+    }
+    return &col_moves_[(offset * col_variants_ + variant) * 2 + forward];
+  }
+
+  Rules rules_;
+  int row_variants_;
+  int col_variants_;
+  PermutationFn row_permutation_;
+  PermutationFn col_permutation_;
+  // Indexed by (offset * variants + variant) * 2 + forward.
+  std::vector<Permutation<num_rows, num_cols>> row_moves_;
+  std::vector<Permutation<num_rows, num_cols>> col_moves_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "move_table.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+// A board with a few colors and every kind of flag sprinkled around.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> randomBoard(std::mt19937 &rng) {
+  const int flags[] = {HORIZ, VERT,      UP,    DOWN,   LEFT,
+                       RIGHT, LIGHTNING, FIXED, ENABLER};
+  Board<num_rows, num_cols> board;
+  for (auto &row : board) {
+    for (int &cell : row) {
+      cell = rng() % 4;
+      for (int flag : flags) {
+        if (rng() % 8 == 0) {
+          cell |= flag;
+        }
+      }
+    }
+  }
+  return board;
+}
+
+// Checks that MoveTable agrees with moves.h for every move in every mode and
+// validation on some random boards.
+template <std::size_t num_rows, std::size_t num_cols> void checkAllModes() {
+  const Mode modes[] = {Mode::BASIC,  Mode::WIDE_2,   Mode::WIDE_3,
+                        Mode::WIDE_4, Mode::GEAR,     Mode::CAROUSEL,
+                        Mode::BANDAGED, Mode::LIGHTNING};
+  std::mt19937 rng(num_rows * 10 + num_cols);
+  for (Mode mode : modes) {
+    for (int validation = 0; validation < 16; ++validation) {
+      Rules rules{mode, mode, static_cast<Validation>(validation)};
+      MoveTable<num_rows, num_cols> moves(rules);
+      for (int i = 0; i < 20; ++i) {
+        Board<num_rows, num_cols> board = randomBoard<num_rows, num_cols>(rng);
+        for (bool forward : {false, true}) {
+          for (size_t row = 0; row < num_rows; ++row) {
+            EXPECT_EQ(moves.rowMove(board, row, forward),
+                      rowMove(board, row, forward, rules.row_mode,
+                              rules.validation))
+                << modeToString(mode) << " row " << row;
+          }
+          for (size_t col = 0; col < num_cols; ++col) {
+            EXPECT_EQ(moves.colMove(board, col, forward),
+                      colMove(board, col, forward, rules.col_mode,
+                              rules.validation))
+                << modeToString(mode) << " col " << col;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(MoveTable, Permutation) {
+  const Board<2, 3> moved = {{
+      {{2, 0, 1}},
+      {{3, 4, 5}},
+  }};
+  auto permutation = Permutation<2, 3>::fromLabels(moved);
+  EXPECT_EQ(permutation.size, 3);
+
+  const Board<2, 3> b = {{
+      {{10, 11, 12}},
+      {{13, 14, 15}},
+  }};
+  const Board<2, 3> expected = {{
+      {{12, 10, 11}},
+      {{13, 14, 15}},
+  }};
+  EXPECT_EQ(permutation.apply(b), expected);
+}
+
+TEST(MoveTable, MoveNumbers) {
+  EXPECT_EQ((kNumMoves<2, 3>), 10);
+  EXPECT_EQ(moveToString<2>(0), "R0");
+  EXPECT_EQ(moveToString<2>(3), "R1'");
+  EXPECT_EQ(moveToString<2>(4), "C0");
+  EXPECT_EQ(moveToString<2>(9), "C2'");
+
+  const Board<2, 3> b = {{
+      {{0, 1, 2}},
+      {{3, 4, 5}},
+  }};
+  MoveTable<2, 3> moves(Rules{});
+  EXPECT_EQ(moves.permutation(b, 3), moves.rowPermutation(b, 1, false));
+  EXPECT_EQ(moves.permutation(b, 8), moves.colPermutation(b, 2, true));
+}
+
+TEST(MoveTable, MatchesMoves) {
+  checkAllModes<1, 3>();
+  checkAllModes<2, 2>();
+  checkAllModes<3, 4>();
+  checkAllModes<4, 4>();
+  checkAllModes<5, 3>();
+  checkAllModes<6, 6>();
+}
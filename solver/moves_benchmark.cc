@@ -0,0 +1,294 @@
+// Benchmarks for the move kernels in moves.h and board.h.
+//
+// Every board size from 2x2 to 6x6 is measured with every mode and every
+// combination of validations, so a change to one kernel shows up next to the
+// cases it didn't touch. Run with
+//
+//   bazel run -c opt :moves_benchmark -- --benchmark_filter=RowMove/4x4
+//
+// Each iteration makes every move of its kind once, so items_per_second is
+// moves per second.
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "benchmark/benchmark.h"
+#include "board.h"
+#include "enums.h"
+#include "moves.h"
+#include "packed_board.h"
+
+namespace {
+
+constexpr std::array<Mode, 8> kModes = {
+    Mode::WIDE_1,   Mode::WIDE_2,   Mode::WIDE_3,    Mode::WIDE_4,
+    Mode::GEAR,     Mode::CAROUSEL, Mode::BANDAGED, Mode::LIGHTNING,
+};
+// Every combination of validations, from NONE to
+// ARROWS+DYNAMIC+ENABLER+STATIC.
+constexpr std::array<Validation, 16> kValidations = [] {
+  std::array<Validation, 16> ret = {};
+  for (size_t i = 0; i < ret.size(); ++i) {
+    ret[i] = static_cast<Validation>(i);
+  }
+  return ret;
+}();
+
+// A board with a few colours and whichever special cells |mode| and
+// |validation| look at, so that some moves are allowed and some aren't.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> makeBoard(Mode mode, Validation validation) {
+  Board<num_rows, num_cols> board;
+  for (size_t row = 0; row < num_rows; ++row) {
+    for (size_t col = 0; col < num_cols; ++col) {
+      board[row][col] = (row + 2 * col) % 3 + 1;
+    }
+  }
+  if ((validation & Validation::ARROWS) != Validation::NONE) {
+    board[0][1] |= HORIZ;
+    board[1][0] |= VERT;
+  }
+  if ((validation & (Validation::DYNAMIC | Validation::STATIC)) !=
+      Validation::NONE) {
+    board[1][1] |= FIXED;
+  }
+  if ((validation & Validation::ENABLER) != Validation::NONE) {
+    board[0][0] = ENABLER;
+  }
+  if (mode == Mode::BANDAGED) {
+    board[0][0] |= RIGHT | DOWN;
+    board[0][1] |= LEFT;
+    board[1][0] |= UP;
+  } else if (mode == Mode::LIGHTNING) {
+    board[num_rows - 1][num_cols - 1] |= LIGHTNING;
+  }
+  return board;
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_RowMove(benchmark::State &state, Mode mode, Validation validation) {
+  const Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(mode, validation);
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < num_rows; ++offset) {
+      for (bool forward : {true, false}) {
+        benchmark::DoNotOptimize(
+            rowMove(board, offset, forward, mode, validation));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_rows);
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_ColMove(benchmark::State &state, Mode mode, Validation validation) {
+  const Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(mode, validation);
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < num_cols; ++offset) {
+      for (bool forward : {true, false}) {
+        benchmark::DoNotOptimize(
+            colMove(board, offset, forward, mode, validation));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * num_cols);
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_SlideRow(benchmark::State &state) {
+  Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(Mode::WIDE_1, Validation::NONE);
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < num_rows; ++offset) {
+      slideRow(board, offset, true);
+    }
+    benchmark::DoNotOptimize(board);
+  }
+  state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_SlideCol(benchmark::State &state) {
+  Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(Mode::WIDE_1, Validation::NONE);
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < num_cols; ++offset) {
+      slideCol(board, offset, true);
+    }
+    benchmark::DoNotOptimize(board);
+  }
+  state.SetItemsProcessed(state.iterations() * num_cols);
+}
+
+// The std::hash specialization in board.h.
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_BoardHash(benchmark::State &state) {
+  Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(Mode::WIDE_1, Validation::NONE);
+  std::hash<Board<num_rows, num_cols>> hasher;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(board);
+    benchmark::DoNotOptimize(hasher(board));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Packing a board into the key the searches hash, see packed_board.h.
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_KeyHash(benchmark::State &state) {
+  Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(Mode::WIDE_1, Validation::NONE);
+  CellAlphabet alphabet(
+      std::vector<int>(&board[0][0], &board[0][0] + num_rows * num_cols));
+  withCodec<num_rows, num_cols>(alphabet, [&](const auto &codec) {
+    KeyHash hasher;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(board);
+      benchmark::DoNotOptimize(hasher(codec.encode(board)));
+    }
+    return 0;
+  });
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Calls |validate| on every move of each kind, with the line summaries built
+// once as the searches do.
+template <std::size_t num_rows, std::size_t num_cols, typename Validate>
+void validateAll(benchmark::State &state, Mode mode, Validation validation,
+                 const Validate &validate) {
+  const Board<num_rows, num_cols> board =
+      makeBoard<num_rows, num_cols>(mode, validation);
+  const LineFlags<num_rows, num_cols> lines(board);
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < num_rows; ++offset) {
+      for (bool forward : {true, false}) {
+        benchmark::DoNotOptimize(
+            validate(board, lines, offset, forward, validation, true));
+      }
+    }
+    for (size_t offset = 0; offset < num_cols; ++offset) {
+      for (bool forward : {true, false}) {
+        benchmark::DoNotOptimize(
+            validate(board, lines, offset, forward, validation, false));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * (num_rows + num_cols));
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_ValidateWideMove(benchmark::State &state, Validation validation) {
+  validateAll<num_rows, num_cols>(
+      state, Mode::WIDE_1, validation,
+      [](const auto &board, const auto &lines, int offset, bool forward,
+         Validation validation, bool row) {
+        return row ? validateWideRowMove(board, lines, offset, forward,
+                                         validation, 1)
+                   : validateWideColMove(board, lines, offset, forward,
+                                         validation, 1);
+      });
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_ValidateGearMove(benchmark::State &state, Validation validation) {
+  validateAll<num_rows, num_cols>(
+      state, Mode::GEAR, validation,
+      [](const auto &board, const auto &lines, int offset, bool forward,
+         Validation validation, bool row) {
+        return row ? validateGearRowMove(board, lines, offset, forward,
+                                         validation)
+                   : validateGearColMove(board, lines, offset, forward,
+                                         validation);
+      });
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_ValidateCarouselMove(benchmark::State &state, Validation validation) {
+  validateAll<num_rows, num_cols>(
+      state, Mode::CAROUSEL, validation,
+      [](const auto &board, const auto &lines, int offset, bool forward,
+         Validation validation, bool row) {
+        return row ? validateCarouselRowMove(board, lines, offset, forward,
+                                             validation)
+                   : validateCarouselColMove(board, lines, offset, forward,
+                                             validation);
+      });
+}
+
+template <std::size_t num_rows, std::size_t num_cols>
+void BM_ValidateLightningMove(benchmark::State &state, Validation validation) {
+  validateAll<num_rows, num_cols>(
+      state, Mode::LIGHTNING, validation,
+      [](const auto &board, const auto &lines, int offset, bool forward,
+         Validation validation, bool row) {
+        return row ? validateLightningRowMove(board, lines, offset, forward,
+                                              validation)
+                   : validateLightningColMove(board, lines, offset, forward,
+                                              validation);
+      });
+}
+
+template <std::size_t n> void registerSize() {
+  const std::string size = absl::StrCat(n, "x", n);
+  for (Mode mode : kModes) {
+    if (!moveFits(mode, n)) {
+      continue;
+    }
+    for (Validation validation : kValidations) {
+      const std::string name = absl::StrCat(
+          size, "/", absl::StrReplaceAll(modeToString(mode), {{" ", "_"}}),
+          "/", validationToString(validation));
+      benchmark::RegisterBenchmark(("RowMove/" + name).c_str(),
+                                   BM_RowMove<n, n>, mode, validation);
+      benchmark::RegisterBenchmark(("ColMove/" + name).c_str(),
+                                   BM_ColMove<n, n>, mode, validation);
+    }
+  }
+
+  benchmark::RegisterBenchmark(("SlideRow/" + size).c_str(), BM_SlideRow<n, n>);
+  benchmark::RegisterBenchmark(("SlideCol/" + size).c_str(), BM_SlideCol<n, n>);
+  benchmark::RegisterBenchmark(("BoardHash/" + size).c_str(),
+                               BM_BoardHash<n, n>);
+  benchmark::RegisterBenchmark(("KeyHash/" + size).c_str(), BM_KeyHash<n, n>);
+
+  const std::pair<const char *, void (*)(benchmark::State &, Validation)>
+      validators[] = {
+          {"ValidateWideMove", BM_ValidateWideMove<n, n>},
+          {"ValidateGearMove", BM_ValidateGearMove<n, n>},
+          {"ValidateCarouselMove", BM_ValidateCarouselMove<n, n>},
+          {"ValidateLightningMove", BM_ValidateLightningMove<n, n>},
+      };
+  for (const auto &[name, validator] : validators) {
+    for (Validation validation : kValidations) {
+      benchmark::RegisterBenchmark(
+          absl::StrCat(name, "/", size, "/", validationToString(validation))
+              .c_str(),
+          validator, validation);
+    }
+  }
+}
+
+template <std::size_t... sizes>
+void registerSizes(std::index_sequence<sizes...>) {
+  (registerSize<sizes + 2>(), ...);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  registerSizes(std::make_index_sequence<5>());
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
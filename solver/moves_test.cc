@@ -775,6 +775,25 @@ TEST(Board, LightningDynamicMove) {
   EXPECT_EQ(b, lightningColMove(b, 1, false, Validation::DYNAMIC));
 }
 
+// A line of length 1 has no cell before its end to check.
+TEST(Board, LightningDynamicMoveOneCell) {
+  const Board<1, 3> row = {{
+      {{0 | LIGHTNING, 1 | FIXED, 2}},
+  }};
+  EXPECT_TRUE(validateLightningColMove(row, 0, true, Validation::DYNAMIC));
+  EXPECT_TRUE(validateLightningColMove(row, 0, false, Validation::DYNAMIC));
+  EXPECT_FALSE(validateLightningColMove(row, 1, true, Validation::DYNAMIC));
+
+  const Board<3, 1> col = {{
+      {{0 | LIGHTNING}},
+      {{1 | FIXED}},
+      {{2}},
+  }};
+  EXPECT_TRUE(validateLightningRowMove(col, 0, true, Validation::DYNAMIC));
+  EXPECT_TRUE(validateLightningRowMove(col, 0, false, Validation::DYNAMIC));
+  EXPECT_FALSE(validateLightningRowMove(col, 1, true, Validation::DYNAMIC));
+}
+
 TEST(Board, LightningEnablerMove) {
   const Board<2, 3> b = {{
       {{0 | LIGHTNING, 1, 2 | ENABLER}},
@@ -0,0 +1,143 @@
+// Numbers the arrangements of a multiset densely, so that a table indexed by
+// arrangement needs no hashing and no keys.
+//
+// Arrangements are lists of N symbols from 0 to k - 1 with a fixed number of
+// each symbol. An arrangement is ranked as a sequence of combinations: which
+// of the N places hold a 0, then which of the places left hold a 1, and so on.
+// Each combination is ranked with the combinatorial number system and the
+// ranks are combined in mixed radix. That takes one pass over the list with a
+// table lookup and an add per place, and no divisions.
+#ifndef LOOPINGDICE_MULTISET_RANK
+#define LOOPINGDICE_MULTISET_RANK
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <std::size_t N> class MultisetRanker {
+public:
+  using Arrangement = std::array<uint8_t, N>;
+
+  // |counts[s]| is how many times symbol s appears. The counts must add up to
+  // N, there can be at most N + 1 of them, and the number of arrangements
+  // must fit in 55 bits; see countMultiset.
+  explicit MultisetRanker(std::vector<int> counts)
+      : counts_(std::move(counts)), size_(countMultiset(counts_)) {
+    int places = N;
+    for (int count : counts_) {
+      radices_.push_back(kBinomials.at(places, count));
+      places -= count;
+    }
+  }
+
+  // The number of distinct arrangements of |counts|, or 0 if it doesn't fit
+  // in 55 bits.
+  static uint64_t countMultiset(const std::vector<int> &counts) {
+    uint64_t ret = 1;
+    int n = 0;
+    for (int count : counts) {
+      // Multiply by n + 1 choose 1, n + 2 choose 2, ..., each of which
+      // divides evenly.
+      for (int i = 1; i <= count; ++i) {
+        ++n;
+        if (ret > kMaxSize / n) {
+          return 0;
+        }
+        ret = ret * n / i;
+      }
+    }
+    return ret;
+  }
+
+  uint64_t size() const { return size_; }
+  const std::vector<int> &counts() const { return counts_; }
+
+  // |arrangement| must have the counts this was built with.
+  uint64_t rank(const Arrangement &arrangement) const {
+    // How many of each symbol have been passed, and the rank of each
+    // symbol's combination so far.
+    std::array<int, kMaxSymbols> seen;
+    std::array<uint64_t, kMaxSymbols> ranks;
+    std::fill_n(seen.begin(), counts_.size(), 0);
+    std::fill_n(ranks.begin(), counts_.size(), 0);
+    for (std::size_t i = 0; i < N; ++i) {
+      int symbol = arrangement[i];
+      // This place's index among those not taken by smaller symbols.
+      int place = i;
+      for (int smaller = 0; smaller < symbol; ++smaller) {
+        place -= seen[smaller];
+      }
+      ranks[symbol] += kBinomials.at(place, seen[symbol] + 1);
+      ++seen[symbol];
+    }
+    uint64_t ret = 0;
+    for (size_t symbol = 0; symbol < counts_.size(); ++symbol) {
+      ret = ret * radices_[symbol] + ranks[symbol];
+    }
+    return ret;
+  }
+
+  Arrangement unrank(uint64_t rank) const {
+    std::array<uint64_t, kMaxSymbols> ranks;
+    for (size_t symbol = counts_.size(); symbol-- > 0;) {
+      ranks[symbol] = rank % radices_[symbol];
+      rank /= radices_[symbol];
+    }
+    // Place each symbol, smallest first, in the places the smaller ones left.
+    Arrangement ret{};
+    std::array<bool, N> taken{};
+    for (size_t symbol = 0; symbol < counts_.size(); ++symbol) {
+      // Index in |ret| of each place not yet taken.
+      std::array<uint8_t, N> places;
+      int num_places = 0;
+      for (std::size_t i = 0; i < N; ++i) {
+        if (!taken[i]) {
+          places[num_places++] = i;
+        }
+      }
+      // Decode the combination, highest place first.
+      uint64_t r = ranks[symbol];
+      int place = num_places;
+      for (int j = counts_[symbol]; j > 0; --j) {
+        do {
+          --place;
+        } while (kBinomials.at(place, j) > r);
+        r -= kBinomials.at(place, j);
+        ret[places[place]] = symbol;
+        taken[places[place]] = true;
+      }
+    }
+    return ret;
+  }
+
+private:
+  static constexpr uint64_t kMaxSize = uint64_t{1} << 55;
+  static constexpr std::size_t kMaxSymbols = N + 1;
+
+  struct Binomials {
+    // choose[n][k] is n choose k, wrapping around if it doesn't fit.
+    std::array<std::array<uint64_t, N + 1>, N + 1> choose{};
+
+    constexpr Binomials() {
+      for (std::size_t n = 0; n <= N; ++n) {
+        choose[n][0] = 1;
+        for (std::size_t k = 1; k <= n; ++k) {
+          choose[n][k] = choose[n - 1][k - 1] + (k < n ? choose[n - 1][k] : 0);
+        }
+      }
+    }
+    uint64_t at(int n, int k) const { return k > n ? 0 : choose[n][k]; }
+  };
+  static inline const Binomials kBinomials;
+
+  std::vector<int> counts_;
+  uint64_t size_;
+  // Number of combinations for each symbol, given the places the smaller
+  // symbols took.
+  std::vector<uint64_t> radices_;
+};
+
+#endif
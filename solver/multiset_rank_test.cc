@@ -0,0 +1,40 @@
+#include "multiset_rank.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+TEST(MultisetRank, CountsArrangements) {
+  EXPECT_EQ(MultisetRanker<5>::countMultiset({2, 1, 2}), 30);
+  EXPECT_EQ(MultisetRanker<4>::countMultiset({4}), 1);
+  EXPECT_EQ(MultisetRanker<4>::countMultiset({0, 4, 0}), 1);
+  EXPECT_EQ(MultisetRanker<64>::countMultiset({32, 32}), 0);
+  EXPECT_EQ(MultisetRanker<64>::countMultiset({60, 4}), 635376);
+}
+
+TEST(MultisetRank, RanksDensely) {
+  MultisetRanker<6> ranker({2, 1, 0, 3});
+  EXPECT_EQ(ranker.size(), 60);
+  MultisetRanker<6>::Arrangement arrangement = {0, 0, 1, 3, 3, 3};
+  std::vector<bool> seen(ranker.size());
+  do {
+    uint64_t rank = ranker.rank(arrangement);
+    ASSERT_LT(rank, ranker.size());
+    EXPECT_FALSE(seen[rank]);
+    seen[rank] = true;
+    EXPECT_EQ(ranker.unrank(rank), arrangement);
+  } while (std::next_permutation(arrangement.begin(), arrangement.end()));
+}
+
+TEST(MultisetRank, LargeBoards) {
+  MultisetRanker<64> ranker({58, 3, 3});
+  MultisetRanker<64>::Arrangement arrangement{};
+  arrangement[3] = arrangement[40] = arrangement[63] = 1;
+  arrangement[0] = arrangement[12] = arrangement[13] = 2;
+  uint64_t rank = ranker.rank(arrangement);
+  EXPECT_LT(rank, ranker.size());
+  EXPECT_EQ(ranker.unrank(rank), arrangement);
+  EXPECT_EQ(ranker.rank(ranker.unrank(ranker.size() - 1)), ranker.size() - 1);
+}
@@ -0,0 +1,236 @@
+// Helpers for packing boards into small integer keys so that visited sets take
+// less memory than storing whole boards.
+//
+// A board is an array of ints but a single puzzle only ever uses a handful of
+// distinct cell values. Each value is remapped to a dense index and stored in
+// the fewest bits that fit every index, so a 4x4 board with 4 distinct cells
+// fits in 32 bits instead of 64 bytes.
+//
+// Codecs can also produce the key of a neighbor from its parent's key and the
+// Permutation (see move_table.h) that the move applies, which only touches the
+// cells that moved.
+#ifndef LOOPINGDICE_PACKED_BOARD
+#define LOOPINGDICE_PACKED_BOARD
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "board.h"
+
+// Maps a puzzle's distinct cell values to 0..size()-1.
+class CellAlphabet {
+public:
+  explicit CellAlphabet(std::vector<int> cells) : cells_(std::move(cells)) {
+    std::sort(cells_.begin(), cells_.end());
+    cells_.erase(std::unique(cells_.begin(), cells_.end()), cells_.end());
+    indices_.assign(cells_.back() + 1, 0);
+    for (size_t i = 0; i < cells_.size(); ++i) {
+      indices_[cells_[i]] = i;
+    }
+    while ((1u << bits_per_cell_) < cells_.size()) {
+      ++bits_per_cell_;
+    }
+  }
+
+  size_t size() const { return cells_.size(); }
+  int bitsPerCell() const { return bits_per_cell_; }
+
+  // |cell| must be one of the cells the alphabet was built from.
+  uint8_t index(int cell) const { return indices_[cell]; }
+  int cell(uint8_t index) const { return cells_[index]; }
+
+private:
+  // Sorted distinct cell values.
+  std::vector<int> cells_;
+  // Inverse of |cells_|. Cells are small non-negative ints (at most the
+  // highest flag in enums.h plus a color) so a direct lookup table is cheap.
+  std::vector<uint8_t> indices_;
+  int bits_per_cell_ = 1;
+};
+
+// The number of bits needed to tell apart |n| values.
+constexpr int bitsFor(size_t n) {
+  int bits = 1;
+  while ((size_t{1} << bits) < n) {
+    ++bits;
+  }
+  return bits;
+}
+
+// Converts boards to and from keys of type |Key|, which must be an unsigned
+// integer type wide enough for num_rows * num_cols * bitsPerCell() bits.
+template <std::size_t num_rows, std::size_t num_cols, typename Key>
+class PackedCodec {
+public:
+  using KeyType = Key;
+
+  explicit PackedCodec(const CellAlphabet &alphabet)
+      : alphabet_(alphabet), bits_(alphabet.bitsPerCell()),
+        mask_((uint64_t{1} << bits_) - 1) {}
+
+  Key encode(const Board<num_rows, num_cols> &board) const {
+    Key key = 0;
+    int shift = 0;
+    for (const auto &row : board) {
+      for (int cell : row) {
+        key |= Key(alphabet_.index(cell)) << shift;
+        shift += bits_;
+      }
+    }
+    return key;
+  }
+
+  Board<num_rows, num_cols> decode(Key key) const {
+    Board<num_rows, num_cols> board;
+    for (auto &row : board) {
+      for (int &cell : row) {
+        cell = alphabet_.cell(static_cast<uint64_t>(key) & mask_);
+        key >>= bits_;
+      }
+    }
+    return board;
+  }
+
+  // The key of |permutation| applied to |board|, whose key is |key|. A null
+  // |permutation| leaves the board as it is.
+  template <typename Permutation>
+  Key move(Key key, const Board<num_rows, num_cols> &board,
+           const Permutation *permutation) const {
+    if (!permutation) {
+      return key;
+    }
+    for (size_t i = 0; i < permutation->size; ++i) {
+      int shift = permutation->to[i] * bits_;
+      int cell = board[permutation->from[i] / num_cols]
+                      [permutation->from[i] % num_cols];
+      key &= ~(Key(mask_) << shift);
+      key |= Key(alphabet_.index(cell)) << shift;
+    }
+    return key;
+  }
+
+private:
+  const CellAlphabet &alphabet_;
+  int bits_;
+  uint64_t mask_;
+};
+
+// The finalizer from splitmix64.
+inline uint64_t splitmix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// A board along with its Zobrist hash.
+template <std::size_t num_rows, std::size_t num_cols> struct HashedBoard {
+  Board<num_rows, num_cols> board;
+  uint64_t hash;
+
+  bool operator==(const HashedBoard &other) const {
+    return hash == other.hash && board == other.board;
+  }
+};
+
+// Fallback for puzzles with too many cells to pack into 128 bits. Keys are the
+// boards themselves along with a Zobrist hash: the XOR of a random number for
+// each (position, cell) pair. Moves update the hash by XOR-ing out the old
+// cells and XOR-ing in the new ones at each moved position.
+template <std::size_t num_rows, std::size_t num_cols> class ZobristCodec {
+public:
+  using KeyType = HashedBoard<num_rows, num_cols>;
+
+  explicit ZobristCodec(const CellAlphabet &alphabet)
+      : alphabet_(alphabet), randoms_(num_rows * num_cols * alphabet.size()) {
+    // Fixed seed so that runs are reproducible.
+    uint64_t state = 0;
+    for (uint64_t &random : randoms_) {
+      state += 0x9e3779b97f4a7c15ULL;
+      random = splitmix64(state);
+    }
+  }
+
+  KeyType encode(const Board<num_rows, num_cols> &board) const {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < num_rows * num_cols; ++i) {
+      hash ^= random(i, board[i / num_cols][i % num_cols]);
+    }
+    return {board, hash};
+  }
+
+  const Board<num_rows, num_cols> &decode(const KeyType &key) const {
+    return key.board;
+  }
+
+  // Same as PackedCodec::move.
+  template <typename Permutation>
+  KeyType move(const KeyType &key, const Board<num_rows, num_cols> &board,
+               const Permutation *permutation) const {
+    if (!permutation) {
+      return key;
+    }
+    KeyType ret = {permutation->apply(board), key.hash};
+    for (size_t i = 0; i < permutation->size; ++i) {
+      size_t to = permutation->to[i];
+      ret.hash ^= random(to, board[to / num_cols][to % num_cols]) ^
+                  random(to, ret.board[to / num_cols][to % num_cols]);
+    }
+    return ret;
+  }
+
+private:
+  uint64_t random(size_t position, int cell) const {
+    return randoms_[position * alphabet_.size() + alphabet_.index(cell)];
+  }
+
+  const CellAlphabet &alphabet_;
+  std::vector<uint64_t> randoms_;
+};
+
+// Hashes keys produced by the codecs above.
+struct KeyHash {
+  // Packed keys have most of their entropy in the low bits so they need
+  // mixing before being used to pick a bucket.
+  size_t operator()(uint64_t key) const {
+    return splitmix64(key);
+  }
+  size_t operator()(absl::uint128 key) const {
+    return (*this)(absl::Uint128Low64(key) ^
+                   (*this)(absl::Uint128High64(key)));
+  }
+  template <std::size_t num_rows, std::size_t num_cols>
+  size_t operator()(const HashedBoard<num_rows, num_cols> &key) const {
+    return key.hash;
+  }
+};
+
+// Calls |f| with the narrowest codec that fits boards made of |alphabet|'s
+// cells and returns whatever |f| returns. Codecs that can never be needed for
+// a board of this size aren't instantiated.
+template <std::size_t num_rows, std::size_t num_cols, typename F>
+auto withCodec(const CellAlphabet &alphabet, F &&f) {
+  constexpr int max_bits = num_rows * num_cols * bitsFor(num_rows * num_cols);
+  const int bits = num_rows * num_cols * alphabet.bitsPerCell();
+  if constexpr (max_bits <= 64) {
+    return f(PackedCodec<num_rows, num_cols, uint64_t>(alphabet));
+  } else if constexpr (max_bits <= 128) {
+    if (bits <= 64) {
+      return f(PackedCodec<num_rows, num_cols, uint64_t>(alphabet));
+    }
+    return f(PackedCodec<num_rows, num_cols, absl::uint128>(alphabet));
+  } else {
+    if (bits <= 64) {
+      return f(PackedCodec<num_rows, num_cols, uint64_t>(alphabet));
+    } else if (bits <= 128) {
+      return f(PackedCodec<num_rows, num_cols, absl::uint128>(alphabet));
+    }
+    return f(ZobristCodec<num_rows, num_cols>(alphabet));
+  }
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "packed_board.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "move_table.h"
+#include "puzzle.h"
+
+TEST(PackedBoard, CellAlphabet) {
+  CellAlphabet alphabet({UP | 3, 1, 2, 1, UP | 3});
+  EXPECT_EQ(alphabet.size(), 3);
+  EXPECT_EQ(alphabet.bitsPerCell(), 2);
+  EXPECT_EQ(alphabet.index(1), 0);
+  EXPECT_EQ(alphabet.index(2), 1);
+  EXPECT_EQ(alphabet.index(UP | 3), 2);
+  EXPECT_EQ(alphabet.cell(2), UP | 3);
+
+  EXPECT_EQ(CellAlphabet({5, 5}).bitsPerCell(), 1);
+  EXPECT_EQ(CellAlphabet({1, 2}).bitsPerCell(), 1);
+  EXPECT_EQ(CellAlphabet({1, 2, 3, 4, 5}).bitsPerCell(), 3);
+}
+
+TEST(PackedBoard, BitsFor) {
+  EXPECT_EQ(bitsFor(1), 1);
+  EXPECT_EQ(bitsFor(2), 1);
+  EXPECT_EQ(bitsFor(3), 2);
+  EXPECT_EQ(bitsFor(16), 4);
+  EXPECT_EQ(bitsFor(17), 5);
+}
+
+TEST(PackedBoard, RoundTrip64) {
+  const Board<3, 3> b = {{
+      {{1, 2, 3}},
+      {{LEFT | 4, 5, 6}},
+      {{7, FIXED | 8, 9}},
+  }};
+  CellAlphabet alphabet(fromBoard(b));
+  PackedCodec<3, 3, uint64_t> codec(alphabet);
+  EXPECT_EQ(codec.decode(codec.encode(b)), b);
+}
+
+TEST(PackedBoard, RoundTrip128) {
+  Board<4, 5> b;
+  for (size_t row = 0; row < 4; ++row) {
+    for (size_t col = 0; col < 5; ++col) {
+      b[row][col] = row * 5 + col;
+    }
+  }
+  CellAlphabet alphabet(fromBoard(b));
+  // 20 cells * 5 bits doesn't fit in 64 bits.
+  PackedCodec<4, 5, absl::uint128> codec(alphabet);
+  EXPECT_EQ(codec.decode(codec.encode(b)), b);
+}
+
+TEST(PackedBoard, DistinctBoardsGetDistinctKeys) {
+  const Board<2, 2> a = {{
+      {{1, 2}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> b = {{
+      {{2, 1}},
+      {{2, 1}},
+  }};
+  CellAlphabet alphabet(fromBoard(a));
+  PackedCodec<2, 2, uint64_t> codec(alphabet);
+  EXPECT_NE(codec.encode(a), codec.encode(b));
+  EXPECT_EQ(codec.encode(a), codec.encode(a));
+}
+
+// Returns the size of the key withCodec picks for |board|.
+template <std::size_t num_rows, std::size_t num_cols>
+size_t keySize(const Board<num_rows, num_cols> &board) {
+  CellAlphabet alphabet(fromBoard(board));
+  return withCodec<num_rows, num_cols>(alphabet, [&](const auto &codec) {
+    EXPECT_EQ(codec.decode(codec.encode(board)), board);
+    return sizeof(codec.encode(board));
+  });
+}
+
+TEST(PackedBoard, WithCodecPicksNarrowestKey) {
+  Board<8, 8> b;
+  for (size_t row = 0; row < 8; ++row) {
+    b[row].fill(row % 2);
+  }
+  EXPECT_EQ(keySize(b), sizeof(uint64_t));
+
+  for (size_t row = 0; row < 8; ++row) {
+    b[row].fill(row % 4);
+  }
+  EXPECT_EQ(keySize(b), sizeof(absl::uint128));
+
+  // 8 colors need 3 bits each, 192 bits in total.
+  for (size_t row = 0; row < 8; ++row) {
+    b[row].fill(row);
+  }
+  EXPECT_EQ(keySize(b), sizeof(HashedBoard<8, 8>));
+}
+
+// Checks that codec.move gives the same key as encoding the moved board, over
+// a random walk.
+template <std::size_t num_rows, std::size_t num_cols, typename Codec>
+void checkMoves(Board<num_rows, num_cols> board, const Codec &codec,
+                const Rules &rules) {
+  MoveTable<num_rows, num_cols> moves(rules);
+  std::mt19937 rng(1);
+  auto key = codec.encode(board);
+  for (int i = 0; i < 1000; ++i) {
+    int offset = rng() % std::max(num_rows, num_cols);
+    bool forward = rng() % 2;
+    const Permutation<num_rows, num_cols> *permutation =
+        rng() % 2 ? moves.rowPermutation(board, offset % num_rows, forward)
+                  : moves.colPermutation(board, offset % num_cols, forward);
+    key = codec.move(key, board, permutation);
+    if (permutation) {
+      board = permutation->apply(board);
+    }
+    ASSERT_EQ(key, codec.encode(board));
+    ASSERT_EQ(codec.decode(key), board);
+  }
+}
+
+TEST(PackedBoard, Move) {
+  const Board<4, 5> b = {{
+      {{1, 2, 3, 4, 5}},
+      {{6, 7, 8, 9, 10}},
+      {{11, 12, 13, 14, 15}},
+      {{16, 17, 18, 19, 20}},
+  }};
+  CellAlphabet alphabet(fromBoard(b));
+  Rules rules{Mode::GEAR, Mode::WIDE_2, Validation::NONE};
+  checkMoves(b, PackedCodec<4, 5, absl::uint128>(alphabet), rules);
+  checkMoves(b, ZobristCodec<4, 5>(alphabet), rules);
+
+  const Board<3, 3> small = {{
+      {{1, 2, 1}},
+      {{2, 1 | FIXED, 2}},
+      {{1, 2, 1}},
+  }};
+  CellAlphabet small_alphabet(fromBoard(small));
+  rules = {Mode::BASIC, Mode::BASIC, Validation::STATIC};
+  checkMoves(small, PackedCodec<3, 3, uint64_t>(small_alphabet), rules);
+  checkMoves(small, ZobristCodec<3, 3>(small_alphabet), rules);
+}
+
+TEST(PackedBoard, ZobristHashesDiffer) {
+  const Board<2, 2> a = {{
+      {{1, 2}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> b = {{
+      {{2, 1}},
+      {{1, 2}},
+  }};
+  CellAlphabet alphabet(fromBoard(a));
+  ZobristCodec<2, 2> codec(alphabet);
+  EXPECT_NE(codec.encode(a).hash, codec.encode(b).hash);
+  EXPECT_EQ(KeyHash()(codec.encode(a)), codec.encode(a).hash);
+}
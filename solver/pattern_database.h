@@ -0,0 +1,240 @@
+// Pattern databases: exact distances to the goal in a simplified version of
+// the puzzle, looked up as lower bounds for the real one.
+//
+// The simplification, or abstraction, keeps only some cell values, masked to
+// some of their bits, and turns every other cell into the same "don't care"
+// symbol. Every abstract board reachable from the abstract goal is found by a
+// breadth first search and its distance stored in a byte array indexed by
+// MultisetRanker, so lookups need no hashing and the table holds no keys.
+//
+// The search applies every permutation in the move table regardless of
+// validation, so it may find shortcuts the real puzzle doesn't have but never
+// misses a real path. Moves are reversible (a move's inverse is in the table
+// too), so searching out from the goal gives distances to it.
+#ifndef LOOPINGDICE_PATTERN_DATABASE
+#define LOOPINGDICE_PATTERN_DATABASE
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "heuristics.h"
+#include "move_table.h"
+#include "multiset_rank.h"
+
+// Which cells a pattern database keeps track of.
+struct Abstraction {
+  // Applied to each cell value before comparing it with |kept|, e.g. to keep
+  // only the FIXED bit.
+  int mask = ~0;
+  // Masked values that are told apart. Everything else is "don't care".
+  std::vector<int> kept;
+
+  // 0 for "don't care", otherwise 1 + the index of the value in |kept|.
+  uint8_t symbol(int value) const {
+    auto it = std::find(kept.begin(), kept.end(), value & mask);
+    return it == kept.end() ? 0 : 1 + (it - kept.begin());
+  }
+};
+
+// Which moves a pattern database counts. The others are free, which lets a
+// database that counts only row moves be added to one that counts only column
+// moves: no move is counted twice, so the sum is still a lower bound. Adding
+// databases that count the same moves isn't safe even if they keep different
+// cells, since one move here carries cells of every color.
+enum class CountedMoves { ALL, ROWS, COLS };
+
+template <std::size_t num_rows, std::size_t num_cols> class PatternDatabase {
+public:
+  static constexpr size_t kNumCells = num_rows * num_cols;
+
+  // The number of entries a table for |abstraction| of |win| needs, or 0 if
+  // it's too big to rank.
+  static uint64_t tableSize(const Board<num_rows, num_cols> &win,
+                            const Abstraction &abstraction) {
+    return MultisetRanker<kNumCells>::countMultiset(
+        symbolCounts(win, abstraction));
+  }
+
+  // Builds the table. tableSize() bytes plus the largest layer of the search
+  // must fit in memory.
+  PatternDatabase(const Board<num_rows, num_cols> &win,
+                  const MoveTable<num_rows, num_cols> &moves,
+                  Abstraction abstraction,
+                  CountedMoves counted = CountedMoves::ALL)
+      : abstraction_(std::move(abstraction)),
+        ranker_(symbolCounts(win, abstraction_)),
+        distances_(ranker_.size(), kUnknown) {
+    std::vector<Permutation<num_rows, num_cols>> free_moves;
+    std::vector<Permutation<num_rows, num_cols>> counted_moves;
+    moves.forEachPermutation(
+        [&](const Permutation<num_rows, num_cols> &permutation, bool is_row) {
+          bool is_counted = counted == CountedMoves::ALL ||
+                            (counted == CountedMoves::ROWS) == is_row;
+          (is_counted ? counted_moves : free_moves).push_back(permutation);
+        });
+
+    uint64_t goal = ranker_.rank(abstract(win));
+    distances_[goal] = 0;
+    std::vector<uint64_t> layer = {goal};
+    for (int depth = 0; !layer.empty(); ++depth) {
+      // Everything a free move away from this layer is at the same depth.
+      for (size_t i = 0; i < layer.size(); ++i) {
+        visitNeighbors(layer[i], free_moves, depth, layer);
+      }
+      std::vector<uint64_t> next_layer;
+      for (uint64_t rank : layer) {
+        visitNeighbors(rank, counted_moves, depth + 1, next_layer);
+      }
+      layer.swap(next_layer);
+    }
+  }
+
+  uint64_t size() const { return distances_.size(); }
+  size_t memoryUsage() const { return distances_.capacity(); }
+
+  int operator()(const Board<num_rows, num_cols> &board) const {
+    typename MultisetRanker<kNumCells>::Arrangement symbols = abstract(board);
+    std::vector<int> counts(ranker_.counts().size(), 0);
+    for (uint8_t symbol : symbols) {
+      if (symbol >= counts.size()) {
+        return kUnsolvable;
+      }
+      ++counts[symbol];
+    }
+    // Moves only rearrange cells.
+    if (counts != ranker_.counts()) {
+      return kUnsolvable;
+    }
+    uint8_t distance = distances_[ranker_.rank(symbols)];
+    return distance == kUnknown ? kUnsolvable : distance;
+  }
+
+private:
+  // Marks boards that weren't reached. Distances beyond kUnknown - 1 are
+  // stored as kUnknown - 1, which is still a lower bound.
+  static constexpr uint8_t kUnknown = 255;
+
+  static std::vector<int> symbolCounts(const Board<num_rows, num_cols> &win,
+                                       const Abstraction &abstraction) {
+    std::vector<int> counts(abstraction.kept.size() + 1, 0);
+    for (const auto &row : win) {
+      for (int cell : row) {
+        ++counts[abstraction.symbol(cell)];
+      }
+    }
+    return counts;
+  }
+
+  typename MultisetRanker<kNumCells>::Arrangement
+  abstract(const Board<num_rows, num_cols> &board) const {
+    typename MultisetRanker<kNumCells>::Arrangement ret;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      ret[i] = abstraction_.symbol(board[i / num_cols][i % num_cols]);
+    }
+    return ret;
+  }
+
+  // Gives every unvisited board one of |moves| away from |rank| distance
+  // |depth| and adds it to |layer|.
+  void visitNeighbors(uint64_t rank,
+                      const std::vector<Permutation<num_rows, num_cols>> &moves,
+                      int depth, std::vector<uint64_t> &layer) {
+    const auto symbols = ranker_.unrank(rank);
+    for (const auto &permutation : moves) {
+      auto next = symbols;
+      for (size_t i = 0; i < permutation.size; ++i) {
+        next[permutation.to[i]] = symbols[permutation.from[i]];
+      }
+      uint64_t next_rank = ranker_.rank(next);
+      if (distances_[next_rank] == kUnknown) {
+        distances_[next_rank] = std::min(depth, kUnknown - 1);
+        layer.push_back(next_rank);
+      }
+    }
+  }
+
+  Abstraction abstraction_;
+  MultisetRanker<kNumCells> ranker_;
+  std::vector<uint8_t> distances_;
+};
+
+// Sums a database counting only row moves and one counting only column moves,
+// for the same abstraction.
+template <std::size_t num_rows, std::size_t num_cols>
+class AdditivePatternDatabase {
+public:
+  AdditivePatternDatabase(const Board<num_rows, num_cols> &win,
+                          const MoveTable<num_rows, num_cols> &moves,
+                          const Abstraction &abstraction)
+      : rows_(win, moves, abstraction, CountedMoves::ROWS),
+        cols_(win, moves, abstraction, CountedMoves::COLS) {}
+
+  size_t memoryUsage() const {
+    return rows_.memoryUsage() + cols_.memoryUsage();
+  }
+
+  int operator()(const Board<num_rows, num_cols> &board) const {
+    int rows = rows_(board);
+    if (rows == kUnsolvable) {
+      return kUnsolvable;
+    }
+    int cols = cols_(board);
+    return cols == kUnsolvable ? kUnsolvable : rows + cols;
+  }
+
+private:
+  PatternDatabase<num_rows, num_cols> rows_;
+  PatternDatabase<num_rows, num_cols> cols_;
+};
+
+// Splits the values in |win| into groups whose abstractions need at most
+// |max_entries| entries each, for building one database per group. Values are
+// taken rarest first since they make the smallest tables; values that don't
+// fit even on their own are left out.
+template <std::size_t num_rows, std::size_t num_cols>
+std::vector<Abstraction> partitionValues(const Board<num_rows, num_cols> &win,
+                                         uint64_t max_entries) {
+  std::vector<std::pair<int, int>> values; // count, value
+  for (const auto &row : win) {
+    for (int cell : row) {
+      auto it = std::find_if(values.begin(), values.end(),
+                             [&](const auto &v) { return v.second == cell; });
+      if (it == values.end()) {
+        values.push_back({1, cell});
+      } else {
+        ++it->first;
+      }
+    }
+  }
+  std::sort(values.begin(), values.end());
+
+  std::vector<Abstraction> ret;
+  Abstraction current;
+  for (const auto &[count, value] : values) {
+    Abstraction extended = current;
+    extended.kept.push_back(value);
+    uint64_t size = PatternDatabase<num_rows, num_cols>::tableSize(win, extended);
+    if (size != 0 && size <= max_entries) {
+      current = extended;
+      continue;
+    }
+    if (!current.kept.empty()) {
+      ret.push_back(current);
+    }
+    current = Abstraction();
+    current.kept.push_back(value);
+    size = PatternDatabase<num_rows, num_cols>::tableSize(win, current);
+    if (size == 0 || size > max_entries) {
+      current = Abstraction();
+    }
+  }
+  if (!current.kept.empty()) {
+    ret.push_back(current);
+  }
+  return ret;
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include "pattern_database.h"
+
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ida_star.h"
+#include "move_table.h"
+
+namespace {
+
+const Board<3, 3> kWin = {{
+    {{1, 1, 2}},
+    {{2, 3, 3}},
+    {{1, 2, 3 | FIXED}},
+}};
+
+// Random walks from the goal, with the length of a shortest path back.
+std::vector<std::pair<Board<3, 3>, int>>
+randomBoards(const MoveTable<3, 3> &moves) {
+  std::vector<std::pair<Board<3, 3>, int>> ret;
+  std::mt19937 rng(1);
+  for (int i = 0; i < 20; ++i) {
+    Board<3, 3> board = kWin;
+    for (int j = 0; j < 6; ++j) {
+      board = moves.permutation(board, rng() % kNumMoves<3, 3>)->apply(board);
+    }
+    IdaStarResult exact = solveIdaStar(
+        board, kWin, moves, CellDistanceHeuristic<3, 3>(kWin, moves), 6);
+    ret.push_back({board, static_cast<int>(exact.path.size())});
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(PatternDatabase, ExactWhenKeepingEverything) {
+  MoveTable<3, 3> moves(Rules{Mode::BASIC, Mode::GEAR, Validation::NONE});
+  Abstraction everything;
+  everything.kept = {1, 2, 3 | FIXED};
+  EXPECT_EQ((PatternDatabase<3, 3>::tableSize(kWin, everything)), 5040);
+  PatternDatabase<3, 3> database(kWin, moves, everything);
+  EXPECT_EQ(database.size(), 5040);
+  for (const auto &[board, distance] : randomBoards(moves)) {
+    EXPECT_EQ(database(board), distance);
+  }
+}
+
+TEST(PatternDatabase, LowerBound) {
+  MoveTable<3, 3> moves(Rules{Mode::CAROUSEL, Mode::BASIC, Validation::NONE});
+  Abstraction ones;
+  ones.kept = {1};
+  Abstraction fixed;
+  fixed.mask = FIXED;
+  fixed.kept = {FIXED};
+  PatternDatabase<3, 3> ones_database(kWin, moves, ones);
+  PatternDatabase<3, 3> fixed_database(kWin, moves, fixed);
+  AdditivePatternDatabase<3, 3> additive(kWin, moves, ones);
+  EXPECT_EQ(ones_database(kWin), 0);
+  EXPECT_EQ(additive(kWin), 0);
+  for (const auto &[board, distance] : randomBoards(moves)) {
+    EXPECT_LE(ones_database(board), distance);
+    EXPECT_LE(fixed_database(board), distance);
+    EXPECT_LE(additive(board), distance);
+  }
+}
+
+TEST(PatternDatabase, DifferentCellsAreUnsolvable) {
+  MoveTable<3, 3> moves(Rules{Mode::BASIC, Mode::BASIC, Validation::NONE});
+  Abstraction ones;
+  ones.kept = {1};
+  PatternDatabase<3, 3> database(kWin, moves, ones);
+  Board<3, 3> board = kWin;
+  board[1][1] = 1;
+  EXPECT_EQ(database(board), kUnsolvable);
+}
+
+TEST(PatternDatabase, PartitionValues) {
+  using ::testing::ElementsAre;
+  auto kept = [](uint64_t max_entries) {
+    std::vector<std::vector<int>> ret;
+    for (const Abstraction &group : partitionValues(kWin, max_entries)) {
+      ret.push_back(group.kept);
+    }
+    return ret;
+  };
+  // Keeping 3 | FIXED and 3 takes 9! / (1! 2! 6!) = 252 entries, adding 1
+  // takes 5040. 1 or 2 alone take 84 and together 1680.
+  EXPECT_THAT(kept(1000), ElementsAre(ElementsAre(3 | FIXED, 3),
+                                      ElementsAre(1), ElementsAre(2)));
+  EXPECT_THAT(kept(2000),
+              ElementsAre(ElementsAre(3 | FIXED, 3), ElementsAre(1, 2)));
+  // Only 3 | FIXED fits on its own.
+  EXPECT_THAT(kept(10), ElementsAre(ElementsAre(3 | FIXED)));
+}
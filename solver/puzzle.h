@@ -0,0 +1,104 @@
+// Defines a runtime description of a puzzle so that one binary can handle
+// puzzles of any size and mode.
+#ifndef LOOPINGDICE_PUZZLE
+#define LOOPINGDICE_PUZZLE
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+
+// The settings that decide which moves are possible.
+struct Rules {
+  Mode row_mode = Mode::BASIC;
+  Mode col_mode = Mode::BASIC;
+  Validation validation = Validation::NONE;
+};
+
+// A puzzle whose size is only known at runtime. Boards are stored as flat,
+// row-major lists of cells.
+struct Puzzle {
+  size_t num_rows = 0;
+  size_t num_cols = 0;
+  Rules rules;
+  std::vector<int> initial;
+  std::vector<int> win;
+};
+
+// Converts a flat, row-major list of cells into a board. |cells| must contain
+// exactly num_rows * num_cols cells.
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> toBoard(const std::vector<int> &cells) {
+  Board<num_rows, num_cols> board = {};
+  for (size_t row = 0; row < num_rows; ++row) {
+    for (size_t col = 0; col < num_cols; ++col) {
+      board[row][col] = cells[row * num_cols + col];
+    }
+  }
+  return board;
+}
+
+// Inverse of toBoard.
+template <std::size_t num_rows, std::size_t num_cols>
+std::vector<int> fromBoard(const Board<num_rows, num_cols> &board) {
+  std::vector<int> cells;
+  cells.reserve(num_rows * num_cols);
+  for (const auto &row : board) {
+    cells.insert(cells.end(), row.begin(), row.end());
+  }
+  return cells;
+}
+
+// Counts the distinct arrangements of |cells|, i.e. the multinomial
+// coefficient of the cell multiset.
+inline double countArrangements(const std::vector<int> &cells) {
+  std::unordered_map<int, int> counts;
+  for (int cell : cells) {
+    counts[cell] += 1;
+  }
+  double log_states = std::lgamma(cells.size() + 1.0);
+  for (const auto &[cell, count] : counts) {
+    log_states -= std::lgamma(count + 1.0);
+  }
+  return std::exp(log_states);
+}
+
+// Counts the distinct arrangements of the puzzle's cells. This is an upper
+// bound on the number of reachable states and is used to guess how expensive a
+// puzzle is to solve.
+inline double estimateStateSpace(const Puzzle &puzzle) {
+  return countArrangements(puzzle.initial);
+}
+
+// Checks that a puzzle makes sense. Prints the problem and returns a non-zero
+// exit code if it doesn't.
+inline int checkPuzzle(const Puzzle &puzzle) {
+  if (!isCompatible(puzzle.rules.row_mode, puzzle.rules.col_mode)) {
+    std::cout << "Row mode and col mode are not compatible" << std::endl;
+    return 1;
+  }
+  if (!moveFits(puzzle.rules.row_mode, puzzle.num_rows)) {
+    std::cout << "Row move affects too many rows" << std::endl;
+    return 2;
+  }
+  if (!moveFits(puzzle.rules.col_mode, puzzle.num_cols)) {
+    std::cout << "col move affects too many rows" << std::endl;
+    return 3;
+  }
+  if (!sameElements(puzzle.initial, puzzle.win)) {
+    std::cout << "Initial and win must contain the same elements" << std::endl;
+    return 4;
+  }
+  if (puzzle.initial.size() != puzzle.num_rows * puzzle.num_cols) {
+    std::cout << "Expected " << puzzle.num_rows * puzzle.num_cols
+              << " cells but got " << puzzle.initial.size() << std::endl;
+    return 5;
+  }
+  return 0;
+}
+
+#endif
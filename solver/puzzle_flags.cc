@@ -0,0 +1,74 @@
+#include "puzzle_flags.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "enums.h"
+#include "level.h"
+
+ABSL_FLAG(std::string, level, "",
+          "Path to a level file in the app's format. Overrides the other "
+          "puzzle flags.");
+ABSL_FLAG(int, rows, 0, "Number of rows in the puzzle");
+ABSL_FLAG(int, cols, 0, "Number of columns in the puzzle");
+ABSL_FLAG(std::string, row_mode, "BASIC",
+          "How rows move, e.g. \"WIDE 2\" or \"GEAR\"");
+ABSL_FLAG(std::string, col_mode, "BASIC",
+          "How columns move, e.g. \"WIDE 2\" or \"GEAR\"");
+ABSL_FLAG(std::string, validation, "NONE",
+          "Validation rules joined by '+', e.g. \"ENABLER+DYNAMIC\"");
+ABSL_FLAG(std::string, initial, "",
+          "Comma separated, row-major list of cells in the initial state, in "
+          "the same format as level files, e.g. \"1,F 2,U R 3\".");
+ABSL_FLAG(std::string, win, "",
+          "Comma separated, row-major list of cells in the goal state. "
+          "Defaults to --initial.");
+
+std::optional<Puzzle> puzzleFromFlags() {
+  if (!absl::GetFlag(FLAGS_level).empty()) {
+    std::optional<Level> level = loadLevel(absl::GetFlag(FLAGS_level));
+    if (!level) {
+      std::cout << "Couldn't load level from " << absl::GetFlag(FLAGS_level)
+                << std::endl;
+      return std::nullopt;
+    }
+    return level->puzzle;
+  }
+
+  Puzzle puzzle;
+  if (absl::GetFlag(FLAGS_rows) <= 0 || absl::GetFlag(FLAGS_cols) <= 0) {
+    std::cout << "--rows and --cols must be positive" << std::endl;
+    return std::nullopt;
+  }
+  puzzle.num_rows = absl::GetFlag(FLAGS_rows);
+  puzzle.num_cols = absl::GetFlag(FLAGS_cols);
+
+  std::string modes = absl::GetFlag(FLAGS_row_mode) + "|" +
+                      absl::GetFlag(FLAGS_col_mode) + "|" +
+                      absl::GetFlag(FLAGS_validation);
+  std::optional<Rules> rules = parseModes(modes);
+  if (!rules) {
+    std::cout << "Couldn't parse modes: " << modes << std::endl;
+    return std::nullopt;
+  }
+  puzzle.rules = *rules;
+
+  size_t num_cells = puzzle.num_rows * puzzle.num_cols;
+  std::optional<std::vector<int>> initial =
+      parseCells(absl::GetFlag(FLAGS_initial), num_cells);
+  std::optional<std::vector<int>> win = parseCells(
+      absl::GetFlag(FLAGS_win).empty() ? absl::GetFlag(FLAGS_initial)
+                                       : absl::GetFlag(FLAGS_win),
+      num_cells);
+  if (!initial || !win) {
+    std::cout << "Expected " << num_cells << " comma separated cells"
+              << std::endl;
+    return std::nullopt;
+  }
+  puzzle.initial = *initial;
+  puzzle.win = *win;
+
+  return puzzle;
+}
@@ -0,0 +1,14 @@
+// Command line flags shared by the binaries for describing a puzzle.
+#ifndef LOOPINGDICE_PUZZLE_FLAGS
+#define LOOPINGDICE_PUZZLE_FLAGS
+
+#include <optional>
+
+#include "puzzle.h"
+
+// Builds a puzzle from --level or from --rows, --cols, --row_mode, --col_mode,
+// --validation, --initial and --win. Prints the problem and returns nullopt if
+// any of them can't be parsed. If --win is unset it defaults to --initial.
+std::optional<Puzzle> puzzleFromFlags();
+
+#endif
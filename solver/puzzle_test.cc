@@ -0,0 +1,64 @@
+#include "puzzle.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+TEST(Puzzle, ToBoard) {
+  const Board<2, 3> expected = {{
+      {{0, 1, 2}},
+      {{3, 4, 5}},
+  }};
+
+  EXPECT_EQ((toBoard<2, 3>({0, 1, 2, 3, 4, 5})), expected);
+}
+
+TEST(Puzzle, FromBoard) {
+  const Board<3, 2> b = {{
+      {{0, 1}},
+      {{2, 3}},
+      {{4, 5 | FIXED}},
+  }};
+
+  EXPECT_EQ(fromBoard(b), std::vector<int>({0, 1, 2, 3, 4, 5 | FIXED}));
+  EXPECT_EQ((toBoard<3, 2>(fromBoard(b))), b);
+}
+
+TEST(Puzzle, CheckPuzzle) {
+  Puzzle puzzle;
+  puzzle.num_rows = 2;
+  puzzle.num_cols = 2;
+  puzzle.initial = {1, 1, 2, 2};
+  puzzle.win = {1, 2, 1, 2};
+  EXPECT_EQ(checkPuzzle(puzzle), 0);
+
+  puzzle.rules.row_mode = Mode::LIGHTNING;
+  EXPECT_EQ(checkPuzzle(puzzle), 1);
+
+  puzzle.rules.row_mode = Mode::WIDE_3;
+  EXPECT_EQ(checkPuzzle(puzzle), 2);
+
+  puzzle.rules.row_mode = Mode::BASIC;
+  puzzle.rules.col_mode = Mode::WIDE_3;
+  EXPECT_EQ(checkPuzzle(puzzle), 3);
+
+  puzzle.rules.col_mode = Mode::BASIC;
+  puzzle.win = {1, 1, 1, 2};
+  EXPECT_EQ(checkPuzzle(puzzle), 4);
+
+  puzzle.initial = {1, 2, 1};
+  puzzle.win = {1, 2, 1};
+  EXPECT_EQ(checkPuzzle(puzzle), 5);
+}
+
+TEST(Puzzle, EstimateStateSpace) {
+  Puzzle puzzle;
+  puzzle.num_rows = 2;
+  puzzle.num_cols = 2;
+  puzzle.initial = {1, 1, 2, 2};
+  EXPECT_NEAR(estimateStateSpace(puzzle), 6, 1e-6);
+
+  puzzle.initial = {1, 2, 3, 4};
+  EXPECT_NEAR(estimateStateSpace(puzzle), 24, 1e-6);
+
+  puzzle.initial = {1, 1, 1, 1};
+  EXPECT_NEAR(estimateStateSpace(puzzle), 1, 1e-6);
+}
@@ -0,0 +1,198 @@
+// Breadth first search over every arrangement of a puzzle's cells, keeping
+// what's known about each board in bit arrays indexed by its MultisetRanker
+// rank rather than in a set of keys.
+//
+// Each board gets 2 bits holding its depth mod 3, or 3 if it hasn't been
+// reached, and 1 bit saying whether it's been expanded. When every move can be
+// undone, a board's neighbors are one move closer, as close, or one move
+// further, so depth mod 3 is enough to walk back to the start. The bits are
+// spent on every arrangement whether it's reachable or not, so this pays off
+// when a good fraction are, as for full enumerations: a set of packed keys
+// takes 8 or 16 bytes per board reached, before its load factor.
+//
+// A layer is found by scanning the table for boards of the right depth mod 3
+// that haven't been expanded yet, so each layer costs a pass over the table on
+// top of expanding its boards.
+#ifndef LOOPINGDICE_RANKED_BFS
+#define LOOPINGDICE_RANKED_BFS
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "multiset_rank.h"
+#include "packed_board.h"
+#include "puzzle.h"
+#include "snapshot.h"
+
+template <std::size_t num_rows, std::size_t num_cols> class RankedBfs {
+public:
+  static constexpr size_t kNumCells = num_rows * num_cols;
+
+  // The number of arrangements of |board|'s cells, or 0 if there are too many
+  // to rank.
+  static uint64_t tableSize(const Board<num_rows, num_cols> &board) {
+    return MultisetRanker<kNumCells>::countMultiset(
+        symbolCounts(CellAlphabet(fromBoard(board)), board));
+  }
+
+  // Bytes taken by the tables for a search from |board|.
+  static uint64_t memoryNeeded(const Board<num_rows, num_cols> &board) {
+    uint64_t size = tableSize(board);
+    return ((size + 31) / 32 + (size + 63) / 64) * sizeof(uint64_t);
+  }
+
+  // Starts a search from |initial|, for which tableSize() must be nonzero.
+  // |moves| must outlive the search.
+  RankedBfs(const Board<num_rows, num_cols> &initial,
+            const MoveTable<num_rows, num_cols> &moves)
+      : moves_(moves), pruning_(moves), alphabet_(fromBoard(initial)),
+        ranker_(symbolCounts(alphabet_, initial)),
+        depths_((ranker_.size() + 31) / 32, ~uint64_t{0}),
+        expanded_((ranker_.size() + 63) / 64, 0) {
+    setDepthAt(rank(initial), 0);
+    layer_sizes_.push_back(1);
+  }
+
+  // Number of boards at each depth found so far. The last is the frontier.
+  const std::vector<uint64_t> &layerSizes() const { return layer_sizes_; }
+  bool done() const { return layer_sizes_.back() == 0; }
+  size_t memoryUsage() const {
+    return (depths_.capacity() + expanded_.capacity()) * sizeof(uint64_t);
+  }
+
+  // The depth mod 3 of |board|, which must be an arrangement of the initial
+  // board's cells, or -1 if it hasn't been reached.
+  int depthMod3(const Board<num_rows, num_cols> &board) const {
+    int ret = depthAt(rank(board));
+    return ret == kUnreached ? -1 : ret;
+  }
+
+  // Writes the tables so that load() can carry on from here. Call between
+  // layers.
+  void save(SnapshotWriter &writer) const {
+    writer.writeVector(layer_sizes_);
+    writer.writeVector(depths_);
+    writer.writeVector(expanded_);
+  }
+
+  // Replaces this search's tables with ones written by save() for the same
+  // initial board.
+  bool load(SnapshotReader &reader) {
+    const size_t num_depth_words = depths_.size();
+    const size_t num_expanded_words = expanded_.size();
+    return reader.readVector(layer_sizes_) && !layer_sizes_.empty() &&
+           reader.readVector(depths_) &&
+           depths_.size() == num_depth_words &&
+           reader.readVector(expanded_) &&
+           expanded_.size() == num_expanded_words;
+  }
+
+  // Finds the boards one move further than the frontier.
+  void expandLayer() {
+    expandLayer([](const Board<num_rows, num_cols> &) {});
+  }
+
+  // Like expandLayer(), also calling visit(board) on each board in the
+  // frontier as it's expanded.
+  template <typename Visit> void expandLayer(const Visit &visit) {
+    const int depth = (layer_sizes_.size() - 1) % 3;
+    const int next_depth = (depth + 1) % 3;
+    uint64_t found = 0;
+    for (size_t word = 0; word < depths_.size(); ++word) {
+      // Most of a sparse table is unreached.
+      if (depths_[word] == ~uint64_t{0}) {
+        continue;
+      }
+      for (uint64_t index = word * 32;
+           index < std::min<uint64_t>(ranker_.size(), word * 32 + 32);
+           ++index) {
+        if (depthAt(index) != depth || isExpanded(index)) {
+          continue;
+        }
+        setExpanded(index);
+        const Board<num_rows, num_cols> board = unrank(index);
+        visit(board);
+        const LineFlags<num_rows, num_cols> lines = moves_.lineFlags(board);
+        for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+          if (pruning_.skip(-1, move)) {
+            continue;
+          }
+          const Permutation<num_rows, num_cols> *permutation =
+              moves_.permutation(board, lines, move);
+          if (!permutation) {
+            continue;
+          }
+          uint64_t next = rank(permutation->apply(board));
+          if (depthAt(next) == kUnreached) {
+            setDepthAt(next, next_depth);
+            ++found;
+          }
+        }
+      }
+    }
+    layer_sizes_.push_back(found);
+  }
+
+private:
+  static constexpr int kUnreached = 3;
+
+  static std::vector<int> symbolCounts(const CellAlphabet &alphabet,
+                                       const Board<num_rows, num_cols> &board) {
+    std::vector<int> counts(alphabet.size(), 0);
+    for (const auto &row : board) {
+      for (int cell : row) {
+        ++counts[alphabet.index(cell)];
+      }
+    }
+    return counts;
+  }
+
+  uint64_t rank(const Board<num_rows, num_cols> &board) const {
+    typename MultisetRanker<kNumCells>::Arrangement symbols;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      symbols[i] = alphabet_.index(board[i / num_cols][i % num_cols]);
+    }
+    return ranker_.rank(symbols);
+  }
+
+  Board<num_rows, num_cols> unrank(uint64_t index) const {
+    const auto symbols = ranker_.unrank(index);
+    Board<num_rows, num_cols> ret;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      ret[i / num_cols][i % num_cols] = alphabet_.cell(symbols[i]);
+    }
+    return ret;
+  }
+
+  int depthAt(uint64_t index) const {
+    return (depths_[index / 32] >> (index % 32 * 2)) & 3;
+  }
+  void setDepthAt(uint64_t index, int depth) {
+    uint64_t &word = depths_[index / 32];
+    int shift = index % 32 * 2;
+    word = (word & ~(uint64_t{3} << shift)) | (uint64_t(depth) << shift);
+  }
+
+  bool isExpanded(uint64_t index) const {
+    return (expanded_[index / 64] >> (index % 64)) & 1;
+  }
+  void setExpanded(uint64_t index) {
+    expanded_[index / 64] |= uint64_t{1} << (index % 64);
+  }
+
+  const MoveTable<num_rows, num_cols> &moves_;
+  MovePruning<num_rows, num_cols> pruning_;
+  CellAlphabet alphabet_;
+  MultisetRanker<kNumCells> ranker_;
+  // 2 bits per board: its depth mod 3, or kUnreached.
+  std::vector<uint64_t> depths_;
+  // 1 bit per board: whether it's been expanded.
+  std::vector<uint64_t> expanded_;
+  std::vector<uint64_t> layer_sizes_;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "ranked_bfs.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "layered_search.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "packed_board.h"
+
+TEST(RankedBfs, TableSize) {
+  const Board<2, 3> board = {{
+      {{1, 1, 2}},
+      {{2, 3 | FIXED, 1}},
+  }};
+  // 6! / (3! 2! 1!)
+  EXPECT_EQ((RankedBfs<2, 3>::tableSize(board)), 60);
+  // Two words of 2 bit depths and one of 1 bit flags.
+  EXPECT_EQ((RankedBfs<2, 3>::memoryNeeded(board)), 24);
+}
+
+// Finds the same layers as a search over packed keys, and knows the depth of
+// each board mod 3.
+TEST(RankedBfs, MatchesLayeredSearch) {
+  const Board<3, 3> initial = {{
+      {{1, 1 | FIXED, 2}},
+      {{2 | ENABLER, 3, 3}},
+      {{1, 2, 3 | HORIZ}},
+  }};
+  CellAlphabet alphabet(fromBoard(initial));
+  PackedCodec<3, 3, uint64_t> codec(alphabet);
+  for (const Rules &rules :
+       {Rules(), Rules{Mode::BASIC, Mode::BASIC, Validation::DYNAMIC},
+        Rules{Mode::GEAR, Mode::WIDE_2, Validation::ARROWS},
+        Rules{Mode::CAROUSEL, Mode::CAROUSEL,
+              Validation::ARROWS | Validation::DYNAMIC},
+        Rules{Mode::LIGHTNING, Mode::BANDAGED, Validation::ENABLER}}) {
+    MoveTable<3, 3> moves(rules);
+    MovePruning<3, 3> pruning(moves);
+    LayeredSearch<uint64_t> expected(codec.encode(initial), 0);
+    std::vector<uint64_t> expected_sizes;
+    while (!expected.done()) {
+      expected_sizes.push_back(expected.frontierSize());
+      expected.expandLayer(
+          [&](const uint64_t &key) {
+            return exploreNeighbors(codec.decode(key), key, -1, moves, pruning,
+                                    codec);
+          },
+          false);
+    }
+    expected_sizes.push_back(0);
+
+    RankedBfs<3, 3> search(initial, moves);
+    while (!search.done()) {
+      search.expandLayer();
+    }
+    EXPECT_EQ(search.layerSizes(), expected_sizes)
+        << modesToString(rules.row_mode, rules.col_mode, rules.validation);
+    for (uint32_t i = 0; i < expected.nodes().size(); i += 7) {
+      EXPECT_EQ(search.depthMod3(codec.decode(expected.nodes()[i].key)),
+                expected.movesTo(i).size() % 3);
+    }
+  }
+}
+
+TEST(RankedBfs, Unreached) {
+  const Board<2, 2> initial = {{
+      {{1, 2}},
+      {{2, 1 | FIXED}},
+  }};
+  MoveTable<2, 2> moves(Rules{Mode::BASIC, Mode::BASIC, Validation::STATIC});
+  RankedBfs<2, 2> search(initial, moves);
+  while (!search.done()) {
+    search.expandLayer();
+  }
+  // Only the top row and the left column can move, and each just swaps the
+  // two cells in it.
+  EXPECT_EQ(search.layerSizes(), (std::vector<uint64_t>{1, 2, 0}));
+  // The fixed cell never moves.
+  const Board<2, 2> stuck = {{
+      {{1 | FIXED, 2}},
+      {{2, 1}},
+  }};
+  EXPECT_EQ(search.depthMod3(stuck), -1);
+}
+
+// Each layer's boards are visited as they're expanded, so the last nonempty
+// layer's are the boards furthest from the start.
+TEST(RankedBfs, VisitsFrontier) {
+  const Board<2, 3> initial = {{
+      {{1, 1, 2}},
+      {{2, 3, 1}},
+  }};
+  MoveTable<2, 3> moves(Rules{Mode::BASIC, Mode::BASIC, Validation::NONE});
+  RankedBfs<2, 3> search(initial, moves);
+  std::vector<Board<2, 3>> deepest;
+  while (!search.done()) {
+    const uint64_t frontier_size = search.layerSizes().back();
+    const int depth = (search.layerSizes().size() - 1) % 3;
+    std::vector<Board<2, 3>> visited;
+    search.expandLayer(
+        [&](const Board<2, 3> &board) { visited.push_back(board); });
+    ASSERT_EQ(visited.size(), frontier_size);
+    for (const auto &board : visited) {
+      EXPECT_EQ(search.depthMod3(board), depth);
+    }
+    deepest = visited;
+  }
+  EXPECT_FALSE(deepest.empty());
+  const std::vector<uint64_t> &sizes = search.layerSizes();
+  EXPECT_EQ(deepest.size(), sizes[sizes.size() - 2]);
+}
+
+TEST(RankedBfs, ResumesFromSnapshot) {
+  const std::string path = testing::TempDir() + "/ranked_bfs";
+  const Board<3, 3> initial = {{
+      {{1, 1, 2}},
+      {{2, 3, 3}},
+      {{1, 2, 3}},
+  }};
+  MoveTable<3, 3> moves(Rules{Mode::BASIC, Mode::WIDE_2, Validation::NONE});
+  RankedBfs<3, 3> uninterrupted(initial, moves);
+  while (!uninterrupted.done()) {
+    uninterrupted.expandLayer();
+  }
+
+  RankedBfs<3, 3> first(initial, moves);
+  for (int i = 0; i < 3; ++i) {
+    first.expandLayer();
+  }
+  {
+    SnapshotWriter writer(path, "search");
+    first.save(writer);
+    ASSERT_TRUE(writer.commit());
+  }
+  RankedBfs<3, 3> resumed(initial, moves);
+  SnapshotReader reader(path, "search");
+  ASSERT_TRUE(resumed.load(reader));
+  while (!resumed.done()) {
+    resumed.expandLayer();
+  }
+  EXPECT_EQ(resumed.layerSizes(), uninterrupted.layerSizes());
+
+  // Tables for a different arrangement of cells don't fit.
+  const Board<3, 3> other = {{
+      {{1, 1, 1}},
+      {{2, 3, 3}},
+      {{1, 2, 3}},
+  }};
+  RankedBfs<3, 3> wrong(other, moves);
+  SnapshotReader again(path, "search");
+  EXPECT_FALSE(wrong.load(again));
+}
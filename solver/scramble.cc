@@ -2,60 +2,48 @@
 // consider validity.
 
 #include <iostream>
-#include <memory>
-#include <unordered_map>
+#include <optional>
 
-#include <queue>
+#include "absl/flags/parse.h"
 #include "board.h"
+#include "dispatch.h"
 #include "enums.h"
 #include "moves.h"
-
-// Global settings
-constexpr size_t num_rows = 4;
-constexpr size_t num_cols = 4;
-constexpr Board<num_rows, num_cols> initial = {{
-  {{1|RIGHT,1|LEFT,2,2}},
-  {{1,1,2,2}},
-  {{1,1,1,1|DOWN}},
-  {{1,1,1,1|UP}},
-}};
-Mode row_mode = Mode::BANDAGED;
-Mode col_mode = Mode::BANDAGED;
-Validation validation = Validation::NONE;
+#include "puzzle.h"
+#include "puzzle_flags.h"
 
 template<std::size_t num_rows, std::size_t num_cols>
-Board<num_rows, num_cols> randomMove(Board<num_rows, num_cols> board) {
+Board<num_rows, num_cols> randomMove(Board<num_rows, num_cols> board,
+                                     const Rules& rules) {
   unsigned int seed = rand() % (2 * (num_rows + num_cols));
   bool direction = seed % 2;
   seed /= 2;
   if (seed < num_rows) {
-    return rowMove(board, seed, direction, row_mode, validation);
+    return rowMove(board, seed, direction, rules.row_mode, rules.validation);
   } else {
-    return colMove(board, seed - num_rows, direction, col_mode, validation);
+    return colMove(board, seed - num_rows, direction, rules.col_mode,
+                   rules.validation);
   }
 }
 
 
-int main () {
-  if (!isCompatible(row_mode, col_mode)) {
-    std::cout << "Row mode and col mode are not compatible" << std::endl;
-    return 1;
-  }
-  if (!moveFits(row_mode, num_rows)) {
-    std::cout << "Row move affects too many rows" << std::endl;
-    return 2;
+int main (int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<Puzzle> puzzle = puzzleFromFlags();
+  if (!puzzle) {
+    return 7;
   }
-  if (!moveFits(col_mode, num_cols)) {
-    std::cout << "col move affects too many rows" << std::endl;
-    return 3;
+  if (int error = checkPuzzle(*puzzle)) {
+    return error;
   }
   srand (time(NULL));
 
-  Board<num_rows, num_cols> my_board = initial;
-  for (int i = 0; i < 100000; ++i) {
-    my_board = randomMove(my_board);
-  }
-  std::cout << boardToString(my_board, row_mode, "\n") << std::endl;
-
-  return 0;
+  return dispatchBySize(*puzzle, [&](const auto& initial, const auto&) {
+    auto my_board = initial;
+    for (int i = 0; i < 100000; ++i) {
+      my_board = randomMove(my_board, puzzle->rules);
+    }
+    std::cout << boardToString(my_board, puzzle->rules.row_mode, "\n") << std::endl;
+    return 0;
+  });
 }
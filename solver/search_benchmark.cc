@@ -0,0 +1,367 @@
+// Runs the searches over a fixed corpus of levels and compares how fast they
+// go against a baseline, so that changes to the solver can be checked for
+// regressions end to end.
+//
+// Each line of the corpus names an engine and a level:
+//   mitm  solves the level with the meet-in-the-middle search, as mitm does.
+//   bfs   visits every board reachable from the level's goal with the
+//         in-memory breadth first search, as bfs --enumerate does.
+//
+// Every run is forked off so that its peak RSS is its own. The fastest of
+// --repetitions runs is kept. Runs whose states per second fall more than
+// --tolerance below the baseline, or whose peak RSS grows more than that
+// above it, are reported as regressions and make the exit code 1. Runs
+// shorter than --min_wall_ms only have their peak RSS compared.
+//
+// Baselines only mean something on the machine they were recorded on, so
+// --update_baseline writes the machine's CPU into the baseline's header,
+// along with --tolerance. Comparisons use the larger of that and --tolerance,
+// so a baseline from a noisy machine carries the slack it needs. Only -c opt
+// builds run at all. search_benchmark_baseline.tsv is the checked-in baseline;
+// see its header for where it was recorded. On another machine, record a
+// baseline of your own before making a change and compare against it after.
+//
+// Usage, with the flags on one line:
+//   bazel run -c opt :search_benchmark --
+//     --levels_dir=$PWD/../app/src/main/assets/levels
+//     --corpus=$PWD/search_benchmark_corpus.txt
+//     --baseline=$PWD/search_benchmark_baseline.tsv
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "dispatch.h"
+#include "layered_search.h"
+#include "level.h"
+#include "mitm.h"
+#include "move_pruning.h"
+#include "move_table.h"
+#include "packed_board.h"
+#include "puzzle.h"
+
+ABSL_FLAG(std::string, levels_dir, "",
+          "Directory containing level files named <canonical id>.txt");
+ABSL_FLAG(std::string, corpus, "",
+          "File listing the runs to make, one '<engine> <level id>' per line");
+ABSL_FLAG(std::string, baseline, "",
+          "Tab separated results of an earlier run to compare against");
+ABSL_FLAG(bool, update_baseline, false,
+          "Write the results to --baseline instead of comparing with it, "
+          "noting the machine and --tolerance in its header");
+ABSL_FLAG(double, tolerance, 0.2,
+          "Fraction by which states per second may drop, or peak RSS grow, "
+          "before a run counts as a regression");
+ABSL_FLAG(double, min_wall_ms, 20,
+          "Runs that took less than this in the baseline are too quick to "
+          "time reliably, so only their peak RSS is compared");
+ABSL_FLAG(int, repetitions, 3, "Number of times to make each run");
+ABSL_FLAG(int, threads, 1, "Number of threads each search uses");
+
+struct Run {
+  std::string engine;
+  std::string level;
+};
+
+struct Measurement {
+  size_t states_expanded = 0;
+  double states_per_second = 0;
+  long peak_rss_kib = 0;
+  double wall_ms = 0;
+};
+
+constexpr absl::string_view kHeader =
+    "engine\tlevel\tstates_expanded\tstates_per_second\tpeak_rss_kib\twall_ms";
+constexpr absl::string_view kToleranceKey = "# tolerance: ";
+
+// What -c opt builds with. Timings from any other build can't be compared.
+#if defined(NDEBUG) && defined(__OPTIMIZE__)
+constexpr bool kOptimized = true;
+#else
+constexpr bool kOptimized = false;
+#endif
+
+struct Baseline {
+  // Keyed by engine and level.
+  std::map<std::pair<std::string, std::string>, Measurement> runs;
+  // The --tolerance it was recorded with.
+  double tolerance = 0;
+};
+
+std::optional<std::vector<Run>> loadCorpus(const std::string &path) {
+  std::optional<std::string> contents = readFile(path);
+  if (!contents) {
+    return std::nullopt;
+  }
+  std::vector<Run> ret;
+  for (absl::string_view line : absl::StrSplit(*contents, '\n')) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::vector<std::string> parts =
+        absl::StrSplit(line, ' ', absl::SkipEmpty());
+    if (parts.size() != 2 || (parts[0] != "mitm" && parts[0] != "bfs")) {
+      std::cerr << "Bad corpus line: " << line << std::endl;
+      return std::nullopt;
+    }
+    ret.push_back({parts[0], parts[1]});
+  }
+  return ret;
+}
+
+// A missing file is an empty baseline.
+Baseline loadBaseline(const std::string &path) {
+  Baseline ret;
+  std::optional<std::string> contents = readFile(path);
+  if (!contents) {
+    return ret;
+  }
+  for (absl::string_view line : absl::StrSplit(*contents, '\n')) {
+    if (absl::ConsumePrefix(&line, kToleranceKey)) {
+      absl::SimpleAtod(line, &ret.tolerance);
+      continue;
+    }
+    std::vector<absl::string_view> parts = absl::StrSplit(line, '\t');
+    Measurement m;
+    if (parts.size() != 6 || !absl::SimpleAtoi(parts[2], &m.states_expanded) ||
+        !absl::SimpleAtod(parts[3], &m.states_per_second) ||
+        !absl::SimpleAtoi(parts[4], &m.peak_rss_kib) ||
+        !absl::SimpleAtod(parts[5], &m.wall_ms)) {
+      // Including the header.
+      continue;
+    }
+    ret.runs[{std::string(parts[0]), std::string(parts[1])}] = m;
+  }
+  return ret;
+}
+
+// The CPU and number of threads, for the header of a baseline recorded here.
+std::string describeMachine() {
+  std::string cpu = "unknown CPU";
+  if (std::optional<std::string> cpuinfo = readFile("/proc/cpuinfo")) {
+    for (absl::string_view line : absl::StrSplit(*cpuinfo, '\n')) {
+      if (absl::StartsWith(line, "model name")) {
+        cpu = std::string(absl::StripAsciiWhitespace(
+            line.substr(std::min(line.size(), line.find(':') + 1))));
+        break;
+      }
+    }
+  }
+  const unsigned threads = std::thread::hardware_concurrency();
+  return absl::StrCat(cpu, " (", threads,
+                      threads == 1 ? " thread)" : " threads)");
+}
+
+// Visits every board reachable from |root| and returns how many were
+// expanded.
+template <std::size_t num_rows, std::size_t num_cols>
+size_t countReachable(const Board<num_rows, num_cols> &root,
+                      const Rules &rules, int threads) {
+  CellAlphabet alphabet(fromBoard(root));
+  return withCodec<num_rows, num_cols>(alphabet, [&](const auto &codec) {
+    using Key = typename std::decay_t<decltype(codec)>::KeyType;
+    LayeredSearch<Key> search(
+        codec.encode(root),
+        std::min<double>(countArrangements(fromBoard(root)), kMaxReserve),
+        threads);
+    MoveTable<num_rows, num_cols> moves(rules);
+    MovePruning<num_rows, num_cols> pruning(moves);
+    auto neighbors = [&](const Key &key, int last_move) {
+      return exploreNeighbors(codec.decode(key), key, last_move, moves,
+                              pruning, codec);
+    };
+    while (!search.done()) {
+      search.expandLayer(neighbors, false);
+    }
+    return search.expanded();
+  });
+}
+
+// Makes |run| once in this process and returns the states it expanded.
+size_t search(const Run &run, const Puzzle &puzzle) {
+  const int threads = absl::GetFlag(FLAGS_threads);
+  size_t states_expanded = 0;
+  dispatchBySize(puzzle, [&](const auto &initial, const auto &win) {
+    states_expanded =
+        run.engine == "bfs"
+            ? countReachable(win, puzzle.rules, threads)
+            : solveMitm(initial, win, puzzle.rules, threads).states_expanded;
+    return 0;
+  });
+  return states_expanded;
+}
+
+// Makes |run| in a child process so that its peak RSS can be told apart from
+// the runs before it.
+std::optional<Measurement> measure(const Run &run, const Puzzle &puzzle) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return std::nullopt;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    return std::nullopt;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    auto start = std::chrono::steady_clock::now();
+    Measurement m;
+    m.states_expanded = search(run, puzzle);
+    m.wall_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    bool ok = write(fds[1], &m, sizeof(m)) == sizeof(m);
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  Measurement m;
+  bool ok = read(fds[0], &m, sizeof(m)) == sizeof(m);
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) != pid || !ok || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0) {
+    return std::nullopt;
+  }
+  m.peak_rss_kib = usage.ru_maxrss;
+  m.states_per_second =
+      m.wall_ms > 0 ? m.states_expanded / (m.wall_ms / 1000) : 0;
+  return m;
+}
+
+std::string format(const Run &run, const Measurement &m) {
+  return absl::StrJoin({run.engine, run.level,
+                        std::to_string(m.states_expanded),
+                        std::to_string(m.states_per_second),
+                        std::to_string(m.peak_rss_kib),
+                        std::to_string(m.wall_ms)},
+                       "\t");
+}
+
+int main(int argc, char **argv) {
+  absl::ParseCommandLine(argc, argv);
+  std::optional<std::vector<Run>> runs = loadCorpus(absl::GetFlag(FLAGS_corpus));
+  if (!runs) {
+    std::cerr << "Couldn't load corpus from " << absl::GetFlag(FLAGS_corpus)
+              << std::endl;
+    return 2;
+  }
+  if (!kOptimized) {
+    std::cerr << "Build with -c opt; other builds' timings can't be compared"
+              << std::endl;
+    return 2;
+  }
+  const std::string baseline_path = absl::GetFlag(FLAGS_baseline);
+  const Baseline baseline = loadBaseline(baseline_path);
+  if (baseline.runs.empty() && !absl::GetFlag(FLAGS_update_baseline)) {
+    std::cerr << "No baseline at " << baseline_path
+              << ", record one with --update_baseline" << std::endl;
+    return 2;
+  }
+  const double tolerance =
+      std::max(absl::GetFlag(FLAGS_tolerance), baseline.tolerance);
+
+  std::vector<std::string> results;
+  int regressions = 0;
+  std::cout << kHeader << "\tspeed_ratio\trss_ratio\tverdict" << std::endl;
+  for (const Run &run : *runs) {
+    std::string path =
+        absl::GetFlag(FLAGS_levels_dir) + "/" + run.level + ".txt";
+    std::optional<Level> level = loadLevel(path);
+    if (!level || checkPuzzle(level->puzzle) ||
+        !isSupportedSize(level->puzzle.num_rows, level->puzzle.num_cols)) {
+      std::cerr << "Couldn't load level from " << path << std::endl;
+      return 2;
+    }
+
+    std::optional<Measurement> best;
+    for (int i = 0; i < std::max(1, absl::GetFlag(FLAGS_repetitions)); ++i) {
+      std::optional<Measurement> m = measure(run, level->puzzle);
+      if (!m) {
+        std::cerr << "Run of " << run.engine << " on " << run.level
+                  << " failed" << std::endl;
+        return 3;
+      }
+      if (!best || m->wall_ms < best->wall_ms) {
+        best = m;
+      }
+    }
+    results.push_back(format(run, *best));
+
+    std::string speed_ratio = "-";
+    std::string rss_ratio = "-";
+    std::string verdict = "new";
+    auto it = baseline.runs.find({run.engine, run.level});
+    if (it != baseline.runs.end()) {
+      const Measurement &old = it->second;
+      const double speed = best->states_per_second / old.states_per_second;
+      const double rss = double(best->peak_rss_kib) / old.peak_rss_kib;
+      speed_ratio = std::to_string(speed);
+      rss_ratio = std::to_string(rss);
+      std::vector<std::string> problems;
+      if (old.wall_ms >= absl::GetFlag(FLAGS_min_wall_ms) &&
+          speed < 1 - tolerance) {
+        problems.push_back("SLOWER");
+      }
+      if (rss > 1 + tolerance) {
+        problems.push_back("BIGGER");
+      }
+      regressions += !problems.empty();
+      // Not a regression in itself since pruning and the like are meant to
+      // change it, but it makes the speed hard to compare.
+      if (best->states_expanded != old.states_expanded) {
+        problems.push_back("states_expanded was " +
+                           std::to_string(old.states_expanded));
+      }
+      verdict = problems.empty() ? "ok" : absl::StrJoin(problems, ",");
+    }
+    std::cout << results.back() << "\t" << speed_ratio << "\t" << rss_ratio
+              << "\t" << verdict << std::endl;
+  }
+
+  if (absl::GetFlag(FLAGS_update_baseline)) {
+    std::ofstream out(baseline_path);
+    out << "# Recorded with search_benchmark --update_baseline on "
+        << describeMachine() << ", -c opt, --repetitions="
+        << absl::GetFlag(FLAGS_repetitions)
+        << ", --threads=" << absl::GetFlag(FLAGS_threads) << ".\n"
+        << kToleranceKey << absl::GetFlag(FLAGS_tolerance) << "\n"
+        << kHeader << "\n" << absl::StrJoin(results, "\n") << "\n";
+    if (!out) {
+      std::cerr << "Couldn't write baseline to " << baseline_path
+                << std::endl;
+      return 2;
+    }
+    std::cerr << "Wrote baseline to " << baseline_path << std::endl;
+    return 0;
+  }
+  if (regressions > 0) {
+    std::cerr << regressions << " of " << runs->size()
+              << " runs regressed by more than a tolerance of " << tolerance
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
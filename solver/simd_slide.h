@@ -0,0 +1,163 @@
+// Vectorized kernels for sliding a row or column of a board by one cell.
+//
+// A line of up to 8 cells fits in one AVX2 register, so a row is rotated with
+// a single load, shuffle and store, and a column with a single gather of the
+// already rotated cells. Lines of up to 4 cells can also use SSE4.1. The kernel
+// is picked at startup from the CPU's features; callers fall back to their
+// scalar loops whenever these return false.
+//
+// On boards of up to 8x8 the scalar loops are faster: the kernels can't be
+// inlined into code that isn't compiled for AVX2, and a gather costs more than
+// moving 8 ints one at a time. So slideRow and slideCol only use these kernels
+// if LOOPINGDICE_USE_SIMD_SLIDE is defined, e.g. with
+// --copt=-DLOOPINGDICE_USE_SIMD_SLIDE, for measuring on other CPUs.
+#ifndef LOOPINGDICE_SIMD_SLIDE
+#define LOOPINGDICE_SIMD_SLIDE
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LOOPINGDICE_HAS_SIMD_SLIDE 1
+#include <immintrin.h>
+#else
+#define LOOPINGDICE_HAS_SIMD_SLIDE 0
+#endif
+
+enum class SimdLevel { SCALAR, SSE4, AVX2 };
+
+inline SimdLevel detectSimdLevel() {
+#if LOOPINGDICE_HAS_SIMD_SLIDE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SimdLevel::SSE4;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+// Detected once so that each slide only costs a load and a compare.
+inline const SimdLevel kSimdLevel = detectSimdLevel();
+
+// Shuffle controls for rotating the first |len| lanes of a register, indexed
+// by [forward][len]. Lanes from |len| on stay where they are.
+struct SlideTables {
+  int32_t lanes[2][9][8];
+  int32_t mask[9][8];
+  int8_t bytes[2][5][16];
+  int8_t byte_mask[5][16];
+};
+
+constexpr SlideTables makeSlideTables() {
+  SlideTables t{};
+  for (int forward = 0; forward < 2; ++forward) {
+    for (int len = 0; len <= 8; ++len) {
+      for (int i = 0; i < 8; ++i) {
+        int source = i;
+        if (i < len) {
+          source = forward ? (i + len - 1) % len : (i + 1) % len;
+        }
+        t.lanes[forward][len][i] = source;
+        t.mask[len][i] = i < len ? -1 : 0;
+        if (len <= 4 && i < 4) {
+          for (int byte = 0; byte < 4; ++byte) {
+            t.bytes[forward][len][i * 4 + byte] = source * 4 + byte;
+            t.byte_mask[len][i * 4 + byte] = i < len ? -1 : 0;
+          }
+        }
+      }
+    }
+  }
+  return t;
+}
+
+inline constexpr SlideTables kSlideTables = makeSlideTables();
+
+#if LOOPINGDICE_HAS_SIMD_SLIDE
+
+__attribute__((target("avx2"))) inline void
+slideRowAvx2(int *cells, size_t len, size_t available, bool forward) {
+  __m256i lanes = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(kSlideTables.lanes[forward][len]));
+  if (available >= 8) {
+    __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(cells),
+                        _mm256_permutevar8x32_epi32(row, lanes));
+    return;
+  }
+  __m256i mask = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(kSlideTables.mask[len]));
+  __m256i row = _mm256_maskload_epi32(cells, mask);
+  _mm256_maskstore_epi32(cells, mask,
+                         _mm256_permutevar8x32_epi32(row, lanes));
+}
+
+__attribute__((target("avx2"))) inline void
+slideColAvx2(int *cells, size_t len, size_t stride, bool forward) {
+  __m256i mask = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(kSlideTables.mask[len]));
+  __m256i lanes = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(kSlideTables.lanes[forward][len]));
+  __m256i offsets =
+      _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int>(stride)));
+  __m256i col = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), cells,
+                                            offsets, mask, sizeof(int));
+  // There's no scatter in AVX2.
+  alignas(32) int rotated[8];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(rotated), col);
+  for (size_t i = 0; i < len; ++i) {
+    cells[i * stride] = rotated[i];
+  }
+}
+
+// Reads and writes 4 cells, so there must be 4 cells from |cells| on even if
+// |len| is smaller. The cells past |len| are written back unchanged.
+__attribute__((target("sse4.1"))) inline void
+slideRowSse4(int *cells, size_t len, bool forward) {
+  __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells));
+  __m128i bytes = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(kSlideTables.bytes[forward][len]));
+  __m128i mask = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(kSlideTables.byte_mask[len]));
+  __m128i rotated = _mm_shuffle_epi8(row, bytes);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(cells),
+                   _mm_blendv_epi8(row, rotated, mask));
+}
+
+#endif
+
+// Slides the |len| contiguous cells from |cells| on by one, wrapping around.
+// |available| is how many cells can be read from |cells| on. Returns false if
+// no kernel handles this line.
+#if LOOPINGDICE_HAS_SIMD_SLIDE && defined(LOOPINGDICE_USE_SIMD_SLIDE)
+inline bool slideRowSimd(int *cells, size_t len, size_t available,
+                         bool forward) {
+  if (kSimdLevel == SimdLevel::AVX2 && len <= 8) {
+    slideRowAvx2(cells, len, available, forward);
+    return true;
+  }
+  if (kSimdLevel >= SimdLevel::SSE4 && len <= 4 && available >= 4) {
+    slideRowSse4(cells, len, forward);
+    return true;
+  }
+  return false;
+}
+
+// Like slideRowSimd but for |len| cells that are |stride| cells apart.
+inline bool slideColSimd(int *cells, size_t len, size_t stride,
+                         bool forward) {
+  if (kSimdLevel == SimdLevel::AVX2 && len <= 8) {
+    slideColAvx2(cells, len, stride, forward);
+    return true;
+  }
+  return false;
+}
+#else
+inline bool slideRowSimd(int *, size_t, size_t, bool) { return false; }
+inline bool slideColSimd(int *, size_t, size_t, bool) { return false; }
+#endif
+
+#endif
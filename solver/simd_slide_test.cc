@@ -0,0 +1,101 @@
+#include "simd_slide.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+// The expected result of sliding the first |len| of |cells| by one.
+std::vector<int> slid(std::vector<int> cells, size_t len, bool forward) {
+  if (forward) {
+    std::rotate(cells.begin(), cells.begin() + len - 1, cells.begin() + len);
+  } else {
+    std::rotate(cells.begin(), cells.begin() + 1, cells.begin() + len);
+  }
+  return cells;
+}
+
+std::vector<int> iota(size_t size) {
+  std::vector<int> ret(size);
+  for (size_t i = 0; i < size; ++i) {
+    ret[i] = 100 + i;
+  }
+  return ret;
+}
+
+#if LOOPINGDICE_HAS_SIMD_SLIDE
+
+TEST(SimdSlide, Avx2Row) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "No AVX2";
+  }
+  for (size_t len = 1; len <= 8; ++len) {
+    for (bool forward : {false, true}) {
+      // Cells past the row must be left alone.
+      std::vector<int> cells = iota(len + 3);
+      slideRowAvx2(cells.data(), len, len + 3, forward);
+      EXPECT_EQ(cells, slid(iota(len + 3), len, forward)) << len;
+    }
+  }
+}
+
+TEST(SimdSlide, Avx2Col) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "No AVX2";
+  }
+  const size_t stride = 3;
+  for (size_t len = 1; len <= 8; ++len) {
+    for (bool forward : {false, true}) {
+      std::vector<int> cells = iota(len * stride);
+      slideColAvx2(cells.data() + 1, len, stride, forward);
+
+      std::vector<int> col;
+      for (size_t i = 0; i < len; ++i) {
+        col.push_back(100 + i * stride + 1);
+      }
+      col = slid(col, len, forward);
+      std::vector<int> expected = iota(len * stride);
+      for (size_t i = 0; i < len; ++i) {
+        expected[i * stride + 1] = col[i];
+      }
+      EXPECT_EQ(cells, expected) << len;
+    }
+  }
+}
+
+TEST(SimdSlide, Sse4Row) {
+  if (!__builtin_cpu_supports("sse4.1")) {
+    GTEST_SKIP() << "No SSE4.1";
+  }
+  for (size_t len = 1; len <= 4; ++len) {
+    for (bool forward : {false, true}) {
+      std::vector<int> cells = iota(4);
+      slideRowSse4(cells.data(), len, forward);
+      EXPECT_EQ(cells, slid(iota(4), len, forward)) << len;
+    }
+  }
+}
+
+// The unmasked path reads and writes 8 cells.
+TEST(SimdSlide, Avx2RowWithSpareCells) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "No AVX2";
+  }
+  for (size_t len = 1; len <= 8; ++len) {
+    for (bool forward : {false, true}) {
+      std::vector<int> cells = iota(12);
+      slideRowAvx2(cells.data(), len, 12, forward);
+      EXPECT_EQ(cells, slid(iota(12), len, forward)) << len;
+    }
+  }
+}
+
+#endif
+
+TEST(SimdSlide, FallsBackForLongLines) {
+  std::vector<int> cells = iota(9);
+  EXPECT_FALSE(slideRowSimd(cells.data(), 9, 9, true));
+  EXPECT_FALSE(slideColSimd(cells.data(), 9, 1, true));
+  EXPECT_EQ(cells, iota(9));
+}
@@ -0,0 +1,258 @@
+// Binary snapshots of a search's state, so that a long run can be stopped and
+// picked up again with the same results.
+//
+// A snapshot starts with a header naming the search it belongs to, followed by
+// sections that are each a length and that many raw bytes, padded so that
+// every section starts 8 byte aligned. Arrays such as hash tables are written
+// straight from memory, and read back by mapping the file and copying them
+// into place, so nothing is rehashed or parsed. The layout is the machine's
+// own, so a snapshot is only good for the binary that wrote it.
+//
+// A snapshot is written next to its path and renamed over it once complete,
+// so a crash while writing leaves the previous snapshot intact.
+#ifndef LOOPINGDICE_SNAPSHOT
+#define LOOPINGDICE_SNAPSHOT
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// "LDSNAPSH" read as a little endian number.
+constexpr uint64_t kSnapshotMagic = 0x48534e4150534c44ULL;
+// Bump whenever something saved to snapshots changes layout.
+constexpr uint64_t kSnapshotVersion = 1;
+
+class SnapshotWriter {
+public:
+  // |description| identifies the search; see SnapshotReader. Check ok()
+  // before writing.
+  SnapshotWriter(const std::string &path, const std::string &description)
+      : path_(path), temp_path_(path + ".tmp"),
+        file_(std::fopen(temp_path_.c_str(), "wb")) {
+    write(kSnapshotMagic);
+    write(kSnapshotVersion);
+    writeArray(description.data(), description.size());
+  }
+  // Drops the snapshot unless it was committed.
+  ~SnapshotWriter() {
+    if (file_) {
+      std::fclose(file_);
+      std::remove(temp_path_.c_str());
+    }
+  }
+  SnapshotWriter(const SnapshotWriter &) = delete;
+  SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+  bool ok() const { return file_ && ok_; }
+
+  // Writes |size| bytes as one section. For types that are laid out like
+  // trivially copyable ones but aren't, such as atomics.
+  void writeBytes(const void *data, size_t size) {
+    static constexpr char kPadding[8] = {};
+    const uint64_t length = size;
+    put(&length, sizeof(length));
+    put(data, size);
+    put(kPadding, (8 - size % 8) % 8);
+  }
+  template <typename T> void writeArray(const T *data, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    writeBytes(data, count * sizeof(T));
+  }
+  template <typename T> void write(const T &value) { writeArray(&value, 1); }
+  template <typename T> void writeVector(const std::vector<T> &values) {
+    writeArray(values.data(), values.size());
+  }
+
+  // Flushes the snapshot to disk and moves it over the previous one. Returns
+  // whether everything was written.
+  bool commit() {
+    if (!file_) {
+      return false;
+    }
+    ok_ = ok_ && std::fflush(file_) == 0 && fsync(fileno(file_)) == 0;
+    ok_ = std::fclose(std::exchange(file_, nullptr)) == 0 && ok_;
+    if (!ok_) {
+      std::remove(temp_path_.c_str());
+      return false;
+    }
+    return std::rename(temp_path_.c_str(), path_.c_str()) == 0;
+  }
+
+private:
+  void put(const void *data, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    ok_ = ok() && std::fwrite(data, 1, size, file_) == size;
+  }
+
+  std::string path_;
+  std::string temp_path_;
+  std::FILE *file_;
+  bool ok_ = true;
+};
+
+class SnapshotReader {
+public:
+  // Maps the snapshot at |path|. ok() is false if there's none, it's damaged,
+  // or it was written for a search other than |description|.
+  SnapshotReader(const std::string &path, const std::string &description) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(data);
+        size_ = st.st_size;
+      }
+    }
+    close(fd);
+    uint64_t magic = 0;
+    uint64_t version = 0;
+    std::vector<char> found_description;
+    ok_ = data_ != nullptr;
+    ok_ = ok_ && read(magic) && magic == kSnapshotMagic && read(version) &&
+          version == kSnapshotVersion && readVector(found_description) &&
+          std::string(found_description.begin(), found_description.end()) ==
+              description;
+  }
+  ~SnapshotReader() {
+    if (data_) {
+      munmap(const_cast<char *>(data_), size_);
+    }
+  }
+  SnapshotReader(const SnapshotReader &) = delete;
+  SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+  // Whether there was a snapshot to map at all.
+  bool found() const { return data_ != nullptr; }
+  bool ok() const { return ok_; }
+  // Whether every section has been read.
+  bool atEnd() const { return offset_ == size_; }
+
+  // Reads a section written by writeBytes(), which must have been |size|
+  // bytes long.
+  bool readBytes(void *data, size_t size) {
+    if (!ok_ || nextSize() != std::optional<uint64_t>(size)) {
+      return ok_ = false;
+    }
+    std::memcpy(data, data_ + offset_ + sizeof(uint64_t), size);
+    offset_ += sizeof(uint64_t) + (size + 7) / 8 * 8;
+    return true;
+  }
+  template <typename T> bool readArray(T *data, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return readBytes(data, count * sizeof(T));
+  }
+  template <typename T> bool read(T &value) { return readArray(&value, 1); }
+  // Reads an array of any length into |values|.
+  template <typename T> bool readVector(std::vector<T> &values) {
+    const std::optional<uint64_t> size = nextSize();
+    if (!ok_ || !size || *size % sizeof(T) != 0) {
+      return ok_ = false;
+    }
+    values.resize(*size / sizeof(T));
+    return readArray(values.data(), values.size());
+  }
+
+  // Length of the next section, if there's a whole one, so that callers can
+  // check it before allocating room for it. A damaged length can be anything,
+  // so it's checked against what's left before being padded.
+  std::optional<uint64_t> nextSize() const {
+    uint64_t size;
+    if (!data_ || size_ - offset_ < sizeof(size)) {
+      return std::nullopt;
+    }
+    std::memcpy(&size, data_ + offset_, sizeof(size));
+    const uint64_t left = size_ - offset_ - sizeof(size);
+    if (size > left || (size + 7) / 8 * 8 > left) {
+      return std::nullopt;
+    }
+    return size;
+  }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  size_t offset_ = 0;
+  bool ok_ = false;
+};
+
+// Where and how often a search saves snapshots. Nothing is read or written if
+// |path| is empty. With |seconds| of 0 a snapshot is saved at every chance.
+struct CheckpointOptions {
+  std::string path;
+  double seconds = 600;
+};
+
+// Saves snapshots of a search every so often, checked between layers, and
+// picks a search back up from the last one.
+class Checkpointer {
+public:
+  enum class Resume { FRESH, RESUMED, FAILED };
+
+  // |description| should capture everything that decides what the search
+  // finds, such as the puzzle and the codec's key type, so that a snapshot is
+  // never loaded into a different search.
+  Checkpointer(const CheckpointOptions &options, std::string description)
+      : path_(options.path), description_(std::move(description)),
+        interval_(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.seconds))),
+        next_(Clock::now() + interval_) {}
+
+  bool enabled() const { return !path_.empty(); }
+  const std::string &path() const { return path_; }
+
+  // Calls load(reader) if there's a snapshot to resume from. FAILED means
+  // there was one but it couldn't be loaded, after which the search is in no
+  // state to go on.
+  template <typename Load> Resume resume(const Load &load) const {
+    if (!enabled()) {
+      return Resume::FRESH;
+    }
+    SnapshotReader reader(path_, description_);
+    if (!reader.found()) {
+      return Resume::FRESH;
+    }
+    return reader.ok() && load(reader) && reader.ok() && reader.atEnd()
+               ? Resume::RESUMED
+               : Resume::FAILED;
+  }
+
+  // Calls save(writer) and commits the snapshot if it's been long enough
+  // since the last one. Returns false if it couldn't be written.
+  template <typename Save> bool maybeSave(const Save &save) {
+    if (!enabled() || Clock::now() < next_) {
+      return true;
+    }
+    SnapshotWriter writer(path_, description_);
+    save(writer);
+    next_ = Clock::now() + interval_;
+    return writer.commit();
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::string path_;
+  std::string description_;
+  Clock::duration interval_;
+  Clock::time_point next_;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string snapshotPath(const std::string &name) {
+  std::string path = testing::TempDir() + "/" + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+} // namespace
+
+TEST(Snapshot, RoundTrip) {
+  const std::string path = snapshotPath("round_trip");
+  const std::vector<uint32_t> values = {1, 2, 3};
+  {
+    SnapshotWriter writer(path, "search");
+    ASSERT_TRUE(writer.ok());
+    writer.write(uint8_t{7});
+    writer.writeVector(values);
+    writer.writeVector(std::vector<uint64_t>());
+    EXPECT_TRUE(writer.commit());
+  }
+  SnapshotReader reader(path, "search");
+  ASSERT_TRUE(reader.ok());
+  uint8_t value = 0;
+  std::vector<uint32_t> read_values;
+  std::vector<uint64_t> empty = {1};
+  EXPECT_TRUE(reader.read(value));
+  EXPECT_TRUE(reader.readVector(read_values));
+  EXPECT_TRUE(reader.readVector(empty));
+  EXPECT_TRUE(reader.atEnd());
+  EXPECT_EQ(value, 7);
+  EXPECT_EQ(read_values, values);
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(Snapshot, OtherSearch) {
+  const std::string path = snapshotPath("other_search");
+  {
+    SnapshotWriter writer(path, "search");
+    writer.write(1);
+    ASSERT_TRUE(writer.commit());
+  }
+  SnapshotReader reader(path, "another search");
+  EXPECT_TRUE(reader.found());
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST(Snapshot, Missing) {
+  SnapshotReader reader(snapshotPath("missing"), "search");
+  EXPECT_FALSE(reader.found());
+  EXPECT_FALSE(reader.ok());
+}
+
+// Reading past the end, or a section of the wrong size, fails rather than
+// reading garbage.
+TEST(Snapshot, WrongSections) {
+  const std::string path = snapshotPath("wrong_sections");
+  {
+    SnapshotWriter writer(path, "search");
+    writer.write(uint32_t{1});
+    ASSERT_TRUE(writer.commit());
+  }
+  SnapshotReader reader(path, "search");
+  ASSERT_TRUE(reader.ok());
+  uint64_t value;
+  EXPECT_FALSE(reader.read(value));
+  EXPECT_FALSE(reader.ok());
+
+  SnapshotReader again(path, "search");
+  uint32_t small_value;
+  EXPECT_TRUE(again.read(small_value));
+  EXPECT_FALSE(again.read(small_value));
+}
+
+// A damaged or cut off length fails rather than allocating whatever it says.
+TEST(Snapshot, DamagedLength) {
+  const uint64_t length = ~uint64_t{0} - 3;
+  for (size_t written : {sizeof(length), size_t{4}}) {
+    const std::string path = snapshotPath("damaged_length");
+    {
+      SnapshotWriter writer(path, "search");
+      ASSERT_TRUE(writer.commit());
+    }
+    std::FILE *file = std::fopen(path.c_str(), "ab");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fwrite(&length, 1, written, file), written);
+    ASSERT_EQ(std::fclose(file), 0);
+    SnapshotReader reader(path, "search");
+    ASSERT_TRUE(reader.ok());
+    std::vector<char> values;
+    EXPECT_FALSE(reader.readVector(values));
+    EXPECT_FALSE(reader.ok());
+  }
+}
+
+// Nothing replaces the last snapshot until a new one is committed.
+TEST(Snapshot, Uncommitted) {
+  const std::string path = snapshotPath("uncommitted");
+  {
+    SnapshotWriter writer(path, "search");
+    writer.write(1);
+    ASSERT_TRUE(writer.commit());
+  }
+  {
+    SnapshotWriter writer(path, "search");
+    writer.write(2);
+  }
+  SnapshotReader reader(path, "search");
+  int value = 0;
+  EXPECT_TRUE(reader.read(value));
+  EXPECT_EQ(value, 1);
+}
+
+TEST(Checkpointer, SavesAndResumes) {
+  const CheckpointOptions options{snapshotPath("checkpointer"), 0};
+  Checkpointer checkpointer(options, "search");
+  int value = 0;
+  auto load = [&](SnapshotReader &reader) { return reader.read(value); };
+  EXPECT_EQ(checkpointer.resume(load), Checkpointer::Resume::FRESH);
+
+  EXPECT_TRUE(checkpointer.maybeSave(
+      [](SnapshotWriter &writer) { writer.write(42); }));
+  EXPECT_EQ(checkpointer.resume(load), Checkpointer::Resume::RESUMED);
+  EXPECT_EQ(value, 42);
+
+  // A snapshot that isn't all read is taken to be for something else.
+  EXPECT_TRUE(checkpointer.maybeSave([](SnapshotWriter &writer) {
+    writer.write(1);
+    writer.write(2);
+  }));
+  EXPECT_EQ(checkpointer.resume(load), Checkpointer::Resume::FAILED);
+  EXPECT_EQ(Checkpointer(options, "another search").resume(load),
+            Checkpointer::Resume::FAILED);
+}
+
+TEST(Checkpointer, WaitsBetweenSaves) {
+  Checkpointer checkpointer({snapshotPath("waits"), 3600}, "search");
+  bool saved = false;
+  EXPECT_TRUE(
+      checkpointer.maybeSave([&](SnapshotWriter &) { saved = true; }));
+  EXPECT_FALSE(saved);
+}
+
+TEST(Checkpointer, Disabled) {
+  Checkpointer checkpointer({"", 0}, "search");
+  bool called = false;
+  EXPECT_TRUE(
+      checkpointer.maybeSave([&](SnapshotWriter &) { called = true; }));
+  auto load = [&](SnapshotReader &) { return called = true; };
+  EXPECT_EQ(checkpointer.resume(load), Checkpointer::Resume::FRESH);
+  EXPECT_FALSE(called);
+}
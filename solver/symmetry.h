@@ -0,0 +1,322 @@
+// Symmetries of a puzzle, for searching one board out of each set of boards
+// that are the same up to symmetry.
+//
+// A symmetry rearranges the grid, by shifting rows or columns around the
+// torus, mirroring, or transposing a square board, and then relabels cells.
+// For it to preserve distances it has to map the moves onto the moves and
+// keep which of them validation allows, and the relabelling has to take the
+// rearranged goal back to the goal. Then a board and its image are the same
+// number of moves from the goal, and a search only needs to keep the
+// smallest image of each board it reaches: its canonical form.
+//
+// The relabelling is forced by the goal, so colours that are interchangeable
+// on their own (say two stripes that could be swapped) show up as a grid
+// symmetry paired with a relabelling rather than separately.
+//
+// Moves are checked by conjugating every permutation in the move table.
+// Validation can't be checked that way since it looks at the board, so only
+// rearrangements that it's known to respect are tried: the wide modes'
+// checks only ask whether a line contains a flagged cell, which any
+// rearrangement keeps (transposing swaps HORIZ and VERT), except DYNAMIC,
+// which looks at the cell at the end of the line and so rules out shifts.
+// GEAR and CAROUSEL with validation, and BANDAGED and LIGHTNING, whose moves
+// depend on the board, get no symmetries beyond the identity.
+#ifndef LOOPINGDICE_SYMMETRY
+#define LOOPINGDICE_SYMMETRY
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "enums.h"
+#include "move_pruning.h"
+#include "move_table.h"
+
+template <std::size_t num_rows, std::size_t num_cols> struct Symmetry {
+  static constexpr size_t kNumCells = num_rows * num_cols;
+
+  // Cell i of the image is cell from[i] of the original, relabelled.
+  std::array<uint8_t, kNumCells> from;
+  // Cells with value values[j] become images[j]. Values not listed keep
+  // their label.
+  std::vector<int> values;
+  std::vector<int> images;
+
+  // Cell i of the image of |board|.
+  int at(const Board<num_rows, num_cols> &board, size_t i) const {
+    int value = board[from[i] / num_cols][from[i] % num_cols];
+    auto it = std::find(values.begin(), values.end(), value);
+    return it == values.end() ? value : images[it - values.begin()];
+  }
+
+  Board<num_rows, num_cols> apply(const Board<num_rows, num_cols> &board) const {
+    Board<num_rows, num_cols> ret;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      ret[i / num_cols][i % num_cols] = at(board, i);
+    }
+    return ret;
+  }
+};
+
+template <std::size_t num_rows, std::size_t num_cols> class SymmetryGroup {
+public:
+  static constexpr size_t kNumCells = num_rows * num_cols;
+
+  // Finds the symmetries of |moves| that fix |goal|.
+  SymmetryGroup(const MoveTable<num_rows, num_cols> &moves,
+                const Board<num_rows, num_cols> &goal) {
+    Board<num_rows, num_cols> labels;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      labels[i / num_cols][i % num_cols] = i;
+    }
+    symmetries_.push_back(identity());
+    if (!hasSymmetries(moves.rules())) {
+      return;
+    }
+    bool dynamic =
+        (moves.rules().validation & Validation::DYNAMIC) != Validation::NONE;
+    std::vector<Board<num_rows, num_cols>> moved;
+    moves.forEachPermutation(
+        [&](const Permutation<num_rows, num_cols> &permutation, bool) {
+          moved.push_back(permutation.apply(labels));
+        });
+    std::vector<Board<num_rows, num_cols>> tried = {labels};
+    for (bool transpose : {false, true}) {
+      if (transpose && num_rows != num_cols) {
+        continue;
+      }
+      for (bool flip_rows : {false, true}) {
+        for (bool flip_cols : {false, true}) {
+          for (size_t row_shift = 0; row_shift < num_rows; ++row_shift) {
+            for (size_t col_shift = 0; col_shift < num_cols; ++col_shift) {
+              if (dynamic && (row_shift != 0 || col_shift != 0)) {
+                continue;
+              }
+              Board<num_rows, num_cols> rearranged = rearrange(
+                  labels, row_shift, col_shift, flip_rows, flip_cols,
+                  transpose);
+              // Shifts and flips of short sides can coincide.
+              if (std::find(tried.begin(), tried.end(), rearranged) !=
+                  tried.end()) {
+                continue;
+              }
+              tried.push_back(rearranged);
+              Symmetry<num_rows, num_cols> symmetry;
+              for (size_t i = 0; i < kNumCells; ++i) {
+                symmetry.from[i] = rearranged[i / num_cols][i % num_cols];
+              }
+              // Checking the goal first is cheaper and rules out most.
+              if (relabel(goal, symmetry, flip_rows, flip_cols, transpose) &&
+                  preservesMoves(moved, rearranged)) {
+                symmetries_.push_back(std::move(symmetry));
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Includes the identity.
+  const std::vector<Symmetry<num_rows, num_cols>> &symmetries() const {
+    return symmetries_;
+  }
+  size_t size() const { return symmetries_.size(); }
+
+  // The smallest image of |board|. Boards have the same canonical form if
+  // and only if some symmetry takes one to the other.
+  Board<num_rows, num_cols>
+  canonical(const Board<num_rows, num_cols> &board) const {
+    Board<num_rows, num_cols> ret = board;
+    for (size_t j = 1; j < symmetries_.size(); ++j) {
+      // Most images differ from the smallest so far within a few cells, so
+      // compare as they're generated and only finish the smaller ones.
+      const Symmetry<num_rows, num_cols> &symmetry = symmetries_[j];
+      size_t i = 0;
+      int value = 0;
+      for (; i < kNumCells; ++i) {
+        value = symmetry.at(board, i);
+        if (value != ret[i / num_cols][i % num_cols]) {
+          break;
+        }
+      }
+      if (i == kNumCells || value > ret[i / num_cols][i % num_cols]) {
+        continue;
+      }
+      for (; i < kNumCells; ++i) {
+        ret[i / num_cols][i % num_cols] = symmetry.at(board, i);
+      }
+    }
+    return ret;
+  }
+
+private:
+  static Symmetry<num_rows, num_cols> identity() {
+    Symmetry<num_rows, num_cols> ret;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      ret.from[i] = i;
+    }
+    return ret;
+  }
+
+  // Whether rearranging the grid could keep validation's answers; see the
+  // comment at the top.
+  static bool hasSymmetries(const Rules &rules) {
+    for (Mode mode : {rules.row_mode, rules.col_mode}) {
+      switch (mode) {
+      case Mode::BANDAGED:
+      case Mode::LIGHTNING:
+        return false;
+      case Mode::GEAR:
+      case Mode::CAROUSEL:
+        if (rules.validation != Validation::NONE) {
+          return false;
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    return true;
+  }
+
+  // Cell (r, c) of the result is cell (r + row_shift, c + col_shift) of
+  // |board|, after mirroring and then transposing.
+  static Board<num_rows, num_cols>
+  rearrange(const Board<num_rows, num_cols> &board, size_t row_shift,
+            size_t col_shift, bool flip_rows, bool flip_cols, bool transpose) {
+    Board<num_rows, num_cols> ret;
+    for (size_t row = 0; row < num_rows; ++row) {
+      for (size_t col = 0; col < num_cols; ++col) {
+        size_t r = transpose ? col : row;
+        size_t c = transpose ? row : col;
+        r = flip_rows ? num_rows - 1 - r : r;
+        c = flip_cols ? num_cols - 1 - c : c;
+        ret[row][col] = board[(r + row_shift) % num_rows]
+                             [(c + col_shift) % num_cols];
+      }
+    }
+    return ret;
+  }
+
+  // Whether every move, rearranged, is also a move. |moved| holds the labels
+  // after each move and |rearranged| the labels after the rearrangement.
+  static bool
+  preservesMoves(const std::vector<Board<num_rows, num_cols>> &moved,
+                 const Board<num_rows, num_cols> &rearranged) {
+    return std::all_of(moved.begin(), moved.end(), [&](const auto &move) {
+      // Moving then rearranging has to be the same as rearranging then
+      // making some move.
+      Board<num_rows, num_cols> target = applyLabels(rearranged, move);
+      return std::any_of(moved.begin(), moved.end(), [&](const auto &other) {
+        return applyLabels(other, rearranged) == target;
+      });
+    });
+  }
+
+  // Applies the rearrangement |moved| made to the labels to |board|.
+  static Board<num_rows, num_cols>
+  applyLabels(const Board<num_rows, num_cols> &moved,
+              const Board<num_rows, num_cols> &board) {
+    Board<num_rows, num_cols> ret;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      int source = moved[i / num_cols][i % num_cols];
+      ret[i / num_cols][i % num_cols] =
+          board[source / num_cols][source % num_cols];
+    }
+    return ret;
+  }
+
+  // What a cell's direction flags become when the grid is rearranged.
+  static int mapFlags(int value, bool flip_rows, bool flip_cols,
+                      bool transpose) {
+    auto swap = [](int value, int a, int b) {
+      int ret = value & ~(a | b);
+      return ret | (value & a ? b : 0) | (value & b ? a : 0);
+    };
+    // In the same order as rearrange: mirror, then transpose.
+    if (flip_rows) {
+      value = swap(value, UP, DOWN);
+    }
+    if (flip_cols) {
+      value = swap(value, LEFT, RIGHT);
+    }
+    if (transpose) {
+      value = swap(swap(swap(value, HORIZ, VERT), UP, LEFT), DOWN, RIGHT);
+    }
+    return value;
+  }
+
+  // Finds the relabelling that takes |goal|, rearranged by |symmetry|, back
+  // to |goal|. Cells have to keep their flags, apart from the directions
+  // the rearrangement turns. Returns false if there's no such relabelling.
+  static bool relabel(const Board<num_rows, num_cols> &goal,
+                      Symmetry<num_rows, num_cols> &symmetry, bool flip_rows,
+                      bool flip_cols, bool transpose) {
+    constexpr int kFlags = UP | DOWN | LEFT | RIGHT | ENABLER | FIXED |
+                           LIGHTNING | HORIZ | VERT;
+    for (size_t i = 0; i < kNumCells; ++i) {
+      int value =
+          goal[symmetry.from[i] / num_cols][symmetry.from[i] % num_cols];
+      int image = goal[i / num_cols][i % num_cols];
+      if ((image & kFlags) !=
+          (mapFlags(value, flip_rows, flip_cols, transpose) & kFlags)) {
+        return false;
+      }
+      auto it = std::find(symmetry.values.begin(), symmetry.values.end(),
+                          value);
+      if (it != symmetry.values.end()) {
+        if (symmetry.images[it - symmetry.values.begin()] != image) {
+          return false;
+        }
+        continue;
+      }
+      if (std::find(symmetry.images.begin(), symmetry.images.end(), image) !=
+          symmetry.images.end()) {
+        return false;
+      }
+      symmetry.values.push_back(value);
+      symmetry.images.push_back(image);
+    }
+    // Drop the values that stay put so that applying skips them.
+    for (size_t j = symmetry.values.size(); j-- > 0;) {
+      if (symmetry.values[j] == symmetry.images[j]) {
+        symmetry.values.erase(symmetry.values.begin() + j);
+        symmetry.images.erase(symmetry.images.begin() + j);
+      }
+    }
+    return true;
+  }
+
+  std::vector<Symmetry<num_rows, num_cols>> symmetries_;
+};
+
+// The keys of the canonical forms of a board's neighbors, indexed by move
+// number, for searches over canonical boards. Moves that aren't allowed, or
+// that |pruning| always skips, give back |key|. The rest of the pruning
+// doesn't apply since the move into a canonical board isn't known.
+template <std::size_t num_rows, std::size_t num_cols, typename Codec>
+std::array<typename Codec::KeyType, kNumMoves<num_rows, num_cols>>
+exploreCanonicalNeighbors(const Board<num_rows, num_cols> &board,
+                          const typename Codec::KeyType &key,
+                          const MoveTable<num_rows, num_cols> &moves,
+                          const MovePruning<num_rows, num_cols> &pruning,
+                          const Codec &codec,
+                          const SymmetryGroup<num_rows, num_cols> &symmetries) {
+  std::array<typename Codec::KeyType, kNumMoves<num_rows, num_cols>> ret;
+  const LineFlags<num_rows, num_cols> lines = moves.lineFlags(board);
+  for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+    const Permutation<num_rows, num_cols> *permutation =
+        pruning.skip(-1, move) ? nullptr
+                               : moves.permutation(board, lines, move);
+    ret[move] = permutation
+                    ? codec.encode(symmetries.canonical(permutation->apply(board)))
+                    : key;
+  }
+  return ret;
+}
+
+#endif
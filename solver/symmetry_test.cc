@@ -0,0 +1,140 @@
+#include "symmetry.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "move_table.h"
+
+namespace {
+
+template <std::size_t num_rows, std::size_t num_cols>
+Board<num_rows, num_cols> scramble(Board<num_rows, num_cols> board,
+                                   const MoveTable<num_rows, num_cols> &moves,
+                                   std::mt19937 &rng) {
+  for (int i = 0; i < 20; ++i) {
+    int move = rng() % kNumMoves<num_rows, num_cols>;
+    const Permutation<num_rows, num_cols> *permutation =
+        moves.permutation(board, move);
+    if (permutation) {
+      board = permutation->apply(board);
+    }
+  }
+  return board;
+}
+
+// Distances from |goal| to every board reachable from it.
+template <std::size_t num_rows, std::size_t num_cols>
+std::map<Board<num_rows, num_cols>, int>
+distances(const Board<num_rows, num_cols> &goal,
+          const MoveTable<num_rows, num_cols> &moves) {
+  std::map<Board<num_rows, num_cols>, int> ret = {{goal, 0}};
+  std::vector<Board<num_rows, num_cols>> layer = {goal};
+  for (int depth = 1; !layer.empty(); ++depth) {
+    std::vector<Board<num_rows, num_cols>> next;
+    for (const auto &board : layer) {
+      for (int move = 0; move < kNumMoves<num_rows, num_cols>; ++move) {
+        const Permutation<num_rows, num_cols> *permutation =
+            moves.permutation(board, move);
+        if (permutation && ret.emplace(permutation->apply(board), depth).second) {
+          next.push_back(permutation->apply(board));
+        }
+      }
+    }
+    layer = std::move(next);
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(SymmetryGroup, StripedGoal) {
+  const Board<3, 3> win = {{
+      {{1, 1, 1}},
+      {{2, 2, 2}},
+      {{3, 3, 3}},
+  }};
+  MoveTable<3, 3> moves{Rules()};
+  SymmetryGroup<3, 3> symmetries(moves, win);
+  // Any rotation and reflection of the rows, with the colours relabelled to
+  // match, and of the columns. Transposing turns the stripes sideways.
+  EXPECT_EQ(symmetries.size(), 6 * 6);
+  for (const auto &symmetry : symmetries.symmetries()) {
+    EXPECT_EQ(symmetry.apply(win), win);
+  }
+}
+
+TEST(SymmetryGroup, Transpose) {
+  const Board<2, 2> win = {{
+      {{1, 2}},
+      {{2, 1}},
+  }};
+  SymmetryGroup<2, 2> symmetries(MoveTable<2, 2>(Rules()), win);
+  const Board<2, 2> board = {{
+      {{2, 1}},
+      {{2, 1}},
+  }};
+  const Board<2, 2> transposed = {{
+      {{2, 2}},
+      {{1, 1}},
+  }};
+  EXPECT_EQ(symmetries.canonical(board), symmetries.canonical(transposed));
+
+  // Columns moving two at a time don't match rows moving one at a time.
+  const Rules rules = {Mode::WIDE_1, Mode::WIDE_2, Validation::NONE};
+  SymmetryGroup<2, 2> lopsided(MoveTable<2, 2>(rules), win);
+  EXPECT_NE(lopsided.canonical(board), lopsided.canonical(transposed));
+}
+
+TEST(SymmetryGroup, Validation) {
+  const Board<3, 3> win = {{
+      {{1, 1, 1}},
+      {{2 | FIXED, 2 | FIXED, 2 | FIXED}},
+      {{1, 1, 1}},
+  }};
+  // STATIC only cares which lines hold a fixed cell, so the columns can be
+  // rotated as well as mirrored.
+  const Rules fixed = {Mode::BASIC, Mode::BASIC, Validation::STATIC};
+  SymmetryGroup<3, 3> static_symmetries(MoveTable<3, 3>(fixed), win);
+  EXPECT_EQ(static_symmetries.size(), 12);
+  // DYNAMIC cares where in the line it is, so they can only be mirrored.
+  const Rules dynamic = {Mode::BASIC, Mode::BASIC, Validation::DYNAMIC};
+  SymmetryGroup<3, 3> dynamic_symmetries(MoveTable<3, 3>(dynamic), win);
+  EXPECT_EQ(dynamic_symmetries.size(), 4);
+  // Bandaged moves depend on the board.
+  const Rules bandaged = {Mode::BANDAGED, Mode::BANDAGED, Validation::NONE};
+  SymmetryGroup<3, 3> bandaged_symmetries(MoveTable<3, 3>(bandaged), win);
+  EXPECT_EQ(bandaged_symmetries.size(), 1);
+}
+
+// Symmetric boards are the same distance from the goal, and share a
+// canonical form.
+TEST(SymmetryGroup, KeepsDistances) {
+  const Board<3, 3> win = {{
+      {{1, 2, 1}},
+      {{2, 3, 2}},
+      {{1, 2, 1}},
+  }};
+  for (const Rules &rules : {Rules(),
+                             Rules{Mode::GEAR, Mode::GEAR, Validation::NONE},
+                             Rules{Mode::CAROUSEL, Mode::CAROUSEL,
+                                   Validation::NONE},
+                             Rules{Mode::WIDE_2, Mode::WIDE_2,
+                                   Validation::NONE}}) {
+    MoveTable<3, 3> moves(rules);
+    SymmetryGroup<3, 3> symmetries(moves, win);
+    EXPECT_GT(symmetries.size(), 1);
+    std::map<Board<3, 3>, int> distance = distances(win, moves);
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20; ++i) {
+      Board<3, 3> board = scramble(win, moves, rng);
+      for (const auto &symmetry : symmetries.symmetries()) {
+        Board<3, 3> image = symmetry.apply(board);
+        EXPECT_EQ(distance.at(image), distance.at(board));
+        EXPECT_EQ(symmetries.canonical(image), symmetries.canonical(board));
+      }
+    }
+  }
+}
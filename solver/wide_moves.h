@@ -6,12 +6,13 @@
 #include "board.h"
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateWideRowMove(const Board<num_rows, num_cols> &board, int offset,
+bool validateWideRowMove(const Board<num_rows, num_cols> &board,
+                         const LineFlags<num_rows, num_cols> &lines, int offset,
                          bool forward, const Validation &validation,
                          int depth) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (row_contains_fixed_cell(board, offset + i)) {
+      if (row_contains_fixed_cell(lines, offset + i)) {
         return false;
       }
     }
@@ -25,14 +26,14 @@ bool validateWideRowMove(const Board<num_rows, num_cols> &board, int offset,
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (row_contains_arrows_cell(board, offset + i)) {
+      if (row_contains_arrows_cell(lines, offset + i)) {
         return false;
       }
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (row_contains_enabler(board, offset + i)) {
+      if (row_contains_enabler(lines, offset + i)) {
         return true;
       }
     }
@@ -42,6 +43,14 @@ bool validateWideRowMove(const Board<num_rows, num_cols> &board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateWideRowMove(const Board<num_rows, num_cols> &board, int offset,
+                         bool forward, const Validation &validation,
+                         int depth) {
+  return validateWideRowMove(board, LineFlags<num_rows, num_cols>(board),
+                             offset, forward, validation, depth);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> wideRowMove(Board<num_rows, num_cols> board,
                                       int offset, bool forward,
@@ -57,12 +66,13 @@ Board<num_rows, num_cols> wideRowMove(Board<num_rows, num_cols> board,
 }
 
 template <std::size_t num_rows, std::size_t num_cols>
-bool validateWideColMove(const Board<num_rows, num_cols>& board, int offset,
+bool validateWideColMove(const Board<num_rows, num_cols>& board,
+                         const LineFlags<num_rows, num_cols> &lines, int offset,
                          bool forward, const Validation &validation,
                          int depth) {
   if ((validation & Validation::STATIC) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (col_contains_fixed_cell(board, offset + i)) {
+      if (col_contains_fixed_cell(lines, offset + i)) {
         return false;
       }
     }
@@ -76,14 +86,14 @@ bool validateWideColMove(const Board<num_rows, num_cols>& board, int offset,
   }
   if ((validation & Validation::ARROWS) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (col_contains_arrows_cell(board, offset + i)) {
+      if (col_contains_arrows_cell(lines, offset + i)) {
         return false;
       }
     }
   }
   if ((validation & Validation::ENABLER) != Validation::NONE) {
     for (int i = 0; i < depth; ++i) {
-      if (col_contains_enabler(board, offset + i)) {
+      if (col_contains_enabler(lines, offset + i)) {
         return true;
       }
     }
@@ -93,6 +103,14 @@ bool validateWideColMove(const Board<num_rows, num_cols>& board, int offset,
   return true;
 }
 
+template <std::size_t num_rows, std::size_t num_cols>
+bool validateWideColMove(const Board<num_rows, num_cols> &board, int offset,
+                         bool forward, const Validation &validation,
+                         int depth) {
+  return validateWideColMove(board, LineFlags<num_rows, num_cols>(board),
+                             offset, forward, validation, depth);
+}
+
 template <std::size_t num_rows, std::size_t num_cols>
 Board<num_rows, num_cols> wideColMove(Board<num_rows, num_cols> board,
                                       int offset, bool forward,